@@ -31,14 +31,19 @@
 #include <QPushButton>
 #include <QRadioButton>
 #include <QSpinBox>
+#include <QTimer>
 #include <QVBoxLayout>
 #include <QWhatsThis>
 
 using namespace CalendarSupport;
 using namespace Qt::Literals::StringLiterals;
+using namespace std::chrono_literals;
+
 ArchiveDialog::ArchiveDialog(const Akonadi::ETMCalendar::Ptr &cal, Akonadi::IncidenceChanger *changer, QWidget *parent)
     : QDialog(parent)
+    , mPreviewTimer(new QTimer(this))
     , mUser1Button(new QPushButton(this))
+    , mArchiver(new EventArchiver(this))
 {
     setWindowTitle(i18nc("@title:window", "Archive/Delete Past Events and To-dos"));
     auto mainLayout = new QVBoxLayout(this);
@@ -185,6 +190,22 @@ ArchiveDialog::ArchiveDialog(const Akonadi::ETMCalendar::Ptr &cal, Akonadi::Inci
     connect(mDeleteCb, &QCheckBox::toggled, this, &ArchiveDialog::slotEnableUser1);
     connect(mArchiveFile->lineEdit(), &QLineEdit::textChanged, this, &ArchiveDialog::slotEnableUser1);
 
+    mPreviewLabel = new QLabel(topFrame);
+    mPreviewLabel->setWordWrap(true);
+    topLayout->addWidget(mPreviewLabel);
+
+    // Counting the items to archive takes a while on large calendars, so wait
+    // until the user has stopped changing the settings.
+    mPreviewTimer->setSingleShot(true);
+    mPreviewTimer->setInterval(300ms);
+    connect(mPreviewTimer, &QTimer::timeout, this, &ArchiveDialog::slotUpdatePreview);
+    connect(mDateEdit, &KDateComboBox::dateChanged, this, &ArchiveDialog::schedulePreview);
+    connect(mExpiryTimeNumInput, &QSpinBox::valueChanged, this, &ArchiveDialog::schedulePreview);
+    connect(mExpiryUnitsComboBox, &QComboBox::currentIndexChanged, this, &ArchiveDialog::schedulePreview);
+    connect(mEvents, &QCheckBox::toggled, this, &ArchiveDialog::schedulePreview);
+    connect(mTodos, &QCheckBox::toggled, this, &ArchiveDialog::schedulePreview);
+    connect(mDeleteCb, &QCheckBox::toggled, this, &ArchiveDialog::schedulePreview);
+
     // Load settings from KCalPrefs
     mExpiryTimeNumInput->setValue(KCalPrefs::instance()->mExpiryTime);
     mExpiryUnitsComboBox->setCurrentIndex(KCalPrefs::instance()->mExpiryUnit);
@@ -204,6 +225,8 @@ ArchiveDialog::ArchiveDialog(const Akonadi::ETMCalendar::Ptr &cal, Akonadi::Inci
     }
     slotActionChanged();
     connect(mUser1Button, &QPushButton::clicked, this, &ArchiveDialog::slotUser1);
+    connect(mArchiver, &EventArchiver::eventsDeleted, this, &ArchiveDialog::slotEventsDeleted);
+    connect(mArchiver, &EventArchiver::finished, this, &ArchiveDialog::slotArchivingFinished);
 }
 
 ArchiveDialog::~ArchiveDialog() = default;
@@ -219,17 +242,68 @@ void ArchiveDialog::slotActionChanged()
     mDateEdit->setEnabled(mArchiveOnceRB->isChecked());
     mExpiryTimeNumInput->setEnabled(mAutoArchiveRB->isChecked());
     mExpiryUnitsComboBox->setEnabled(mAutoArchiveRB->isChecked());
+    schedulePreview();
+}
+
+void ArchiveDialog::schedulePreview()
+{
+    mPreviewTimer->start();
+}
+
+void ArchiveDialog::slotUpdatePreview()
+{
+    const QDate limitDate = mArchiveOnceRB->isChecked() ? mDateEdit->date()
+                                                        : EventArchiver::autoArchiveLimitDate(mExpiryTimeNumInput->value(), mExpiryUnitsComboBox->currentIndex());
+    if (!mCalendar || !limitDate.isValid() || (!mEvents->isChecked() && !mTodos->isChecked())) {
+        mPreviewLabel->clear();
+        mPreviewLabel->setToolTip(QString());
+        return;
+    }
+
+    const EventArchiver::Preview preview = EventArchiver::preview(mCalendar, limitDate, mEvents->isChecked(), mTodos->isChecked());
+    const QLocale locale = QLocale::system();
+    const QString date = locale.toString(limitDate, QLocale::ShortFormat);
+    if (preview.events == 0 && preview.todos == 0) {
+        mPreviewLabel->setText(i18nc("@info", "There are no items before %1.", date));
+        mPreviewLabel->setToolTip(QString());
+        return;
+    }
+
+    const QString events = i18ncp("@info number of events", "1 event", "%1 events", preview.events);
+    const QString todos = i18ncp("@info number of to-dos", "1 to-do", "%1 to-dos", preview.todos);
+    if (mDeleteCb->isChecked()) {
+        mPreviewLabel->setText(i18nc("@info", "%1 and %2 before %3 will be deleted.", events, todos, date));
+    } else {
+        mPreviewLabel->setText(i18nc("@info",
+                                     "%1 and %2 before %3 will be archived, about %4.",
+                                     events,
+                                     todos,
+                                     date,
+                                     locale.formattedDataSize(preview.estimatedSize)));
+    }
+
+    QStringList collections;
+    collections.reserve(preview.collections.count());
+    for (auto it = preview.collections.cbegin(), end = preview.collections.cend(); it != end; ++it) {
+        collections.append(i18nc("@info:tooltip calendar: number of events, number of to-dos",
+                                 "%1: %2, %3",
+                                 mCalendar->collection(it.key()).displayName(),
+                                 i18ncp("@info number of events", "1 event", "%1 events", it->events),
+                                 i18ncp("@info number of to-dos", "1 to-do", "%1 to-dos", it->todos)));
+    }
+    collections.sort(Qt::CaseInsensitive);
+    mPreviewLabel->setToolTip(collections.join(u'\n'));
 }
 
 // Archive old events
 void ArchiveDialog::slotUser1()
 {
-    EventArchiver archiver;
-    connect(&archiver, &EventArchiver::eventsDeleted, this, &ArchiveDialog::slotEventsDeleted);
-
     KCalPrefs::instance()->mAutoArchive = mAutoArchiveRB->isChecked();
     KCalPrefs::instance()->mExpiryTime = mExpiryTimeNumInput->value();
     KCalPrefs::instance()->mExpiryUnit = mExpiryUnitsComboBox->currentIndex();
+    // Archive what the preview showed.
+    KCalPrefs::instance()->mArchiveEvents = mEvents->isChecked();
+    KCalPrefs::instance()->mArchiveTodos = mTodos->isChecked();
 
     if (mDeleteCb->isChecked()) {
         KCalPrefs::instance()->mArchiveAction = KCalPrefs::actionDelete;
@@ -252,21 +326,34 @@ void ArchiveDialog::slotUser1()
 
         KCalPrefs::instance()->mArchiveFile = destUrl.url();
     }
+    // The dialog is closed once the archiver is finished, so that it still
+    // forwards eventsDeleted().
+    mArchiving = true;
+    setEnabled(false);
     if (KCalPrefs::instance()->mAutoArchive) {
-        archiver.runAuto(mCalendar, mChanger, this, true /*with gui*/);
         Q_EMIT autoArchivingSettingsModified();
-        accept();
+        mArchiver->runAuto(mCalendar, mChanger, this, true /*with gui*/);
     } else {
-        archiver.runOnce(mCalendar, mChanger, mDateEdit->date(), this);
-        accept();
+        mArchiver->runOnce(mCalendar, mChanger, mDateEdit->date(), this);
     }
 }
 
 void ArchiveDialog::slotEventsDeleted()
 {
     Q_EMIT eventsDeleted();
-    if (!KCalPrefs::instance()->mAutoArchive) {
-        accept();
+}
+
+void ArchiveDialog::slotArchivingFinished()
+{
+    mArchiving = false;
+    setEnabled(true);
+    accept();
+}
+
+void ArchiveDialog::reject()
+{
+    if (!mArchiving) {
+        QDialog::reject();
     }
 }
 
@@ -19,6 +19,8 @@ class KUrlRequester;
 class QCheckBox;
 class QRadioButton;
 class QPushButton;
+class QLabel;
+class QTimer;
 
 namespace Akonadi
 {
@@ -27,6 +29,8 @@ class IncidenceChanger;
 
 namespace CalendarSupport
 {
+class EventArchiver;
+
 /*!
  * \class CalendarSupport::ArchiveDialog
  * \inmodule CalendarSupport
@@ -48,6 +52,11 @@ public:
      */
     ~ArchiveDialog() override;
 
+    /*!
+     * Closes the dialog, unless archiving is in progress.
+     */
+    void reject() override;
+
 Q_SIGNALS:
     // connected by KODialogManager to CalendarView
     /*!
@@ -61,10 +70,13 @@ Q_SIGNALS:
 
 private:
     CALENDARSUPPORT_NO_EXPORT void slotEventsDeleted();
+    CALENDARSUPPORT_NO_EXPORT void slotArchivingFinished();
     CALENDARSUPPORT_NO_EXPORT void slotUser1();
     CALENDARSUPPORT_NO_EXPORT void slotEnableUser1();
     CALENDARSUPPORT_NO_EXPORT void slotActionChanged();
     CALENDARSUPPORT_NO_EXPORT void showWhatsThis();
+    CALENDARSUPPORT_NO_EXPORT void schedulePreview();
+    CALENDARSUPPORT_NO_EXPORT void slotUpdatePreview();
     KUrlRequester *mArchiveFile = nullptr;
     KDateComboBox *mDateEdit = nullptr;
     QCheckBox *mDeleteCb = nullptr;
@@ -74,8 +86,13 @@ private:
     QComboBox *mExpiryUnitsComboBox = nullptr;
     QCheckBox *mEvents = nullptr;
     QCheckBox *mTodos = nullptr;
+    QLabel *mPreviewLabel = nullptr;
+    QTimer *const mPreviewTimer;
     Akonadi::IncidenceChanger *mChanger = nullptr;
     Akonadi::ETMCalendar::Ptr mCalendar;
     QPushButton *const mUser1Button;
+    // Works asynchronously, so the dialog stays open until it is finished
+    EventArchiver *const mArchiver;
+    bool mArchiving = false;
 };
 }
@@ -0,0 +1,439 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#include "archivejob.h"
+
+#include <Akonadi/IncidenceChanger>
+
+#include <KCalendarCore/Exceptions>
+#include <KCalendarCore/FileStorage>
+#include <KCalendarCore/ICalFormat>
+#include <KCalendarCore/MemoryCalendar>
+
+#if KCALENDARCORE_VERSION < QT_VERSION_CHECK(6, 30, 0)
+#include <KCalUtils/Stringify>
+#endif
+
+#include "calendarsupport_debug.h"
+#include <KIO/FileCopyJob>
+#include <KIO/StatJob>
+#include <KJobWidgets>
+#include <KLocalizedString>
+
+#include <QFile>
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QPromise>
+#include <QSet>
+#include <QTemporaryFile>
+#include <QThreadPool>
+#include <QTimeZone>
+#include <QTimer>
+
+#include <algorithm>
+#include <utility>
+
+using namespace CalendarSupport;
+
+namespace
+{
+class GroupwareScoppedDisabler
+{
+public:
+    explicit GroupwareScoppedDisabler(Akonadi::IncidenceChanger *changer)
+        : m_changer(changer)
+    {
+        m_wasEnabled = m_changer->groupwareCommunication();
+        m_changer->setGroupwareCommunication(false);
+    }
+
+    ~GroupwareScoppedDisabler()
+    {
+        m_changer->setGroupwareCommunication(m_wasEnabled);
+    }
+
+    bool m_wasEnabled = false;
+    Akonadi::IncidenceChanger *const m_changer;
+};
+
+constexpr int DefaultBatchSize = 100;
+constexpr int DefaultMaxConcurrentBatches = 2;
+
+// Progress at the start of each stage, in percent.
+constexpr unsigned long WriteProgress = 10;
+constexpr unsigned long DeleteProgress = 70;
+
+// Runs in a worker thread. Merges incidences with the archive file at fileName, if
+// that exists, and writes the result back. Returns an error message on failure.
+QString saveArchive(const KCalendarCore::Incidence::List &incidences, const QString &fileName, bool merge, const QPromise<QString> &promise)
+{
+    KCalendarCore::MemoryCalendar::Ptr const archiveCalendar(new KCalendarCore::MemoryCalendar(QTimeZone::systemTimeZone()));
+    for (const KCalendarCore::Incidence::Ptr &incidence : incidences) {
+        archiveCalendar->addIncidence(incidence);
+    }
+
+    KCalendarCore::FileStorage archiveStore(archiveCalendar);
+    auto format = new KCalendarCore::ICalFormat();
+    archiveStore.setSaveFormat(format);
+    archiveStore.setFileName(fileName);
+
+    // Merge with events to be archived.
+    if (merge && !archiveStore.load()) {
+        qCDebug(CALENDARSUPPORT_LOG) << "Can't merge with archive file";
+        return i18n("Cannot read archive file %1.", fileName);
+    }
+    if (promise.isCanceled()) {
+        return {};
+    }
+
+    // Save archive calendar
+    if (!archiveStore.save()) {
+        QString errmess;
+        if (format->exception()) {
+#if KCALENDARCORE_VERSION < QT_VERSION_CHECK(6, 30, 0)
+            errmess = KCalUtils::Stringify::errorMessage(*format->exception());
+#else
+            errmess = format->exception()->errorMessage();
+#endif
+        } else {
+            errmess = i18nc("save failure cause unknown", "Reason unknown");
+        }
+        return i18n("Cannot write archive file %1. %2", fileName, errmess);
+    }
+    return {};
+}
+}
+
+class CalendarSupport::ArchiveJobPrivate
+{
+public:
+    ArchiveJobPrivate(ArchiveJob *qq,
+                      ArchiveJob::Action action,
+                      const Akonadi::ETMCalendar::Ptr &calendar,
+                      Akonadi::IncidenceChanger *changer,
+                      const KCalendarCore::Incidence::List &incidences,
+                      QWidget *widget)
+        : q(qq)
+        , mAction(action)
+        , mCalendar(calendar)
+        , mChanger(changer)
+        , mIncidences(incidences)
+        , mWidget(widget)
+    {
+    }
+
+    void doStart();
+    void cloneIncidences();
+    void prepareArchiveFile();
+    void writeArchive(const QString &fileName, bool merge);
+    void archiveWritten();
+    void deleteIncidences();
+    void deleteNextBatches();
+    void batchDeleted(int changeId, int count, bool success, const QString &errorString);
+    void fail(const QString &errorText);
+
+    ArchiveJob *const q;
+    const ArchiveJob::Action mAction;
+    const Akonadi::ETMCalendar::Ptr mCalendar;
+    const QPointer<Akonadi::IncidenceChanger> mChanger;
+    const KCalendarCore::Incidence::List mIncidences;
+    const QPointer<QWidget> mWidget;
+    QUrl mArchiveUrl;
+
+    // The copies of the incidences written to the archive, owned by the worker thread while it runs
+    KCalendarCore::Incidence::List mClones;
+    QTemporaryFile mTempFile;
+    QFutureWatcher<QString> mWatcher;
+    QPointer<KJob> mSubJob;
+    int mBatchSize = DefaultBatchSize;
+    int mMaxConcurrentBatches = DefaultMaxConcurrentBatches;
+
+    // The items to delete, of which those before mNextItem were handed to the IncidenceChanger
+    Akonadi::Item::List mItems;
+    qsizetype mNextItem = 0;
+    qsizetype mDeletedCount = 0;
+    QSet<int> mPendingChanges;
+    bool mDeleting = false;
+    bool mKilled = false;
+};
+
+void ArchiveJobPrivate::doStart()
+{
+    if (mKilled) {
+        return;
+    }
+    if (!mChanger) {
+        fail(i18n("Cannot delete the items from the calendar."));
+        return;
+    }
+    q->setTotalAmount(KJob::Items, mIncidences.count());
+    if (mAction == ArchiveJob::Archive) {
+        Q_EMIT q->description(q, i18nc("@info:progress", "Archiving"));
+        cloneIncidences();
+        prepareArchiveFile();
+    } else {
+        Q_EMIT q->description(q, i18nc("@info:progress", "Deleting old items"));
+        deleteIncidences();
+    }
+}
+
+void ArchiveJobPrivate::cloneIncidences()
+{
+    // Copy only the incidences to archive, together with the exceptions of the recurring
+    // ones. The time zones they refer to are written out along with them.
+    QSet<QString> uids;
+    uids.reserve(mIncidences.count());
+    for (const KCalendarCore::Incidence::Ptr &incidence : mIncidences) {
+        if (uids.contains(incidence->uid())) {
+            continue;
+        }
+        uids.insert(incidence->uid());
+        const KCalendarCore::Incidence::Ptr mainIncidence = mCalendar->incidence(incidence->uid());
+        const KCalendarCore::Incidence::Ptr source = mainIncidence ? mainIncidence : incidence;
+        mClones.append(KCalendarCore::Incidence::Ptr(source->clone()));
+        if (source->recurs()) {
+            const KCalendarCore::Incidence::List exceptions = mCalendar->instances(source);
+            for (const KCalendarCore::Incidence::Ptr &exception : exceptions) {
+                mClones.append(KCalendarCore::Incidence::Ptr(exception->clone()));
+            }
+        }
+    }
+    q->setPercent(WriteProgress);
+}
+
+void ArchiveJobPrivate::prepareArchiveFile()
+{
+    if (mArchiveUrl.isLocalFile()) {
+        const QString archiveFile = mArchiveUrl.toLocalFile();
+        writeArchive(archiveFile, QFile::exists(archiveFile));
+        return;
+    }
+
+    if (!mTempFile.open()) {
+        qCWarning(CALENDARSUPPORT_LOG) << "Impossible to open file";
+        fail(i18n("Cannot create a temporary file for the archive."));
+        return;
+    }
+
+    // Get or create the archive file
+    auto statJob = KIO::stat(mArchiveUrl, KIO::StatJob::SourceSide, KIO::StatBasic, KIO::HideProgressInfo);
+    KJobWidgets::setWindow(statJob, mWidget);
+    mSubJob = statJob;
+    QObject::connect(statJob, &KJob::result, q, [this](KJob *job) {
+        mSubJob = nullptr;
+        if (job->error()) {
+            // There is no archive yet.
+            writeArchive(mTempFile.fileName(), false);
+            return;
+        }
+        auto copyJob = KIO::file_copy(mArchiveUrl, QUrl::fromLocalFile(mTempFile.fileName()), -1, KIO::Overwrite | KIO::HideProgressInfo);
+        KJobWidgets::setWindow(copyJob, mWidget);
+        mSubJob = copyJob;
+        QObject::connect(copyJob, &KJob::result, q, [this](KJob *job) {
+            mSubJob = nullptr;
+            if (job->error()) {
+                qCDebug(CALENDARSUPPORT_LOG) << "Can't download archive file";
+                fail(i18n("Cannot download archive file %1. %2", mArchiveUrl.toDisplayString(), job->errorString()));
+                return;
+            }
+            writeArchive(mTempFile.fileName(), true);
+        });
+    });
+}
+
+void ArchiveJobPrivate::writeArchive(const QString &fileName, bool merge)
+{
+    auto promise = std::make_shared<QPromise<QString>>();
+    mWatcher.setFuture(promise->future());
+    QThreadPool::globalInstance()->start([promise, incidences = std::exchange(mClones, {}), fileName, merge]() {
+        promise->start();
+        promise->addResult(saveArchive(incidences, fileName, merge, *promise));
+        promise->finish();
+    });
+}
+
+void ArchiveJobPrivate::archiveWritten()
+{
+    if (mKilled) {
+        return;
+    }
+    const QString errorText = mWatcher.future().resultCount() > 0 ? mWatcher.result() : QString();
+    if (!errorText.isEmpty()) {
+        fail(errorText);
+        return;
+    }
+
+    // Upload if necessary
+    if (mArchiveUrl.isLocalFile()) {
+        deleteIncidences();
+        return;
+    }
+    auto copyJob = KIO::file_copy(QUrl::fromLocalFile(mTempFile.fileName()), mArchiveUrl, -1, KIO::Overwrite | KIO::HideProgressInfo);
+    KJobWidgets::setWindow(copyJob, mWidget);
+    mSubJob = copyJob;
+    QObject::connect(copyJob, &KJob::result, q, [this](KJob *job) {
+        mSubJob = nullptr;
+        if (job->error()) {
+            fail(i18n("Cannot write archive. %1", job->errorString()));
+            return;
+        }
+        deleteIncidences();
+    });
+}
+
+void ArchiveJobPrivate::deleteIncidences()
+{
+    if (!mChanger) {
+        fail(i18n("Cannot delete the items from the calendar."));
+        return;
+    }
+    mDeleting = true;
+    q->setPercent(DeleteProgress);
+
+    QObject::connect(mChanger.data(),
+                     &Akonadi::IncidenceChanger::deleteFinished,
+                     q,
+                     [this](int changeId, const QList<Akonadi::Item::Id> &itemIdList, Akonadi::IncidenceChanger::ResultCode resultCode, const QString &errorString) {
+                         batchDeleted(changeId, itemIdList.count(), resultCode == Akonadi::IncidenceChanger::ResultCodeSuccess, errorString);
+                     });
+
+    mItems = mCalendar->itemList(mIncidences);
+    q->setTotalAmount(KJob::Items, mItems.count());
+    deleteNextBatches();
+}
+
+void ArchiveJobPrivate::deleteNextBatches()
+{
+    while (mPendingChanges.count() < mMaxConcurrentBatches && mNextItem < mItems.count()) {
+        const Akonadi::Item::List batch = mItems.mid(mNextItem, mBatchSize);
+        mNextItem += batch.count();
+
+        GroupwareScoppedDisabler const disabler(mChanger); // Disables groupware communication temporarily
+        if (mAction == ArchiveJob::Archive) {
+            // We don't want it to ask to send invitations for each incidence.
+            mChanger->startAtomicOperation(i18n("Archiving events"));
+        }
+        const int changeId = mChanger->deleteIncidences(batch, mWidget);
+        if (mAction == ArchiveJob::Archive) {
+            mChanger->endAtomicOperation();
+        }
+        if (changeId < 0) {
+            fail(i18n("Cannot delete the items from the calendar."));
+            return;
+        }
+        mPendingChanges.insert(changeId);
+    }
+
+    if (mPendingChanges.isEmpty() && mNextItem >= mItems.count()) {
+        if (mDeletedCount > 0) {
+            Q_EMIT q->eventsDeleted();
+        }
+        q->setPercent(100);
+        q->emitResult();
+    }
+}
+
+void ArchiveJobPrivate::batchDeleted(int changeId, int count, bool success, const QString &errorString)
+{
+    if (!mPendingChanges.remove(changeId)) {
+        return;
+    }
+    if (!success) {
+        if (mDeletedCount > 0) {
+            Q_EMIT q->eventsDeleted();
+        }
+        fail(errorString);
+        return;
+    }
+
+    mDeletedCount += count;
+    qCDebug(CALENDARSUPPORT_LOG) << "deleted" << mDeletedCount << "of" << mItems.count() << "items";
+    q->setProcessedAmount(KJob::Items, mDeletedCount);
+    if (!mItems.isEmpty()) {
+        q->setPercent(DeleteProgress + (100 - DeleteProgress) * mDeletedCount / mItems.count());
+    }
+    deleteNextBatches();
+}
+
+void ArchiveJobPrivate::fail(const QString &errorText)
+{
+    q->setError(KJob::UserDefinedError);
+    q->setErrorText(errorText);
+    q->emitResult();
+}
+
+ArchiveJob::ArchiveJob(Action action,
+                       const Akonadi::ETMCalendar::Ptr &calendar,
+                       Akonadi::IncidenceChanger *changer,
+                       const KCalendarCore::Incidence::List &incidences,
+                       QWidget *widget,
+                       QObject *parent)
+    : KJob(parent)
+    , d(new ArchiveJobPrivate(this, action, calendar, changer, incidences, widget))
+{
+    connect(&d->mWatcher, &QFutureWatcher<QString>::finished, this, [this]() {
+        d->archiveWritten();
+    });
+}
+
+ArchiveJob::~ArchiveJob() = default;
+
+void ArchiveJob::setArchiveUrl(const QUrl &url)
+{
+    d->mArchiveUrl = url;
+}
+
+QUrl ArchiveJob::archiveUrl() const
+{
+    return d->mArchiveUrl;
+}
+
+void ArchiveJob::start()
+{
+    QTimer::singleShot(0, this, [this]() {
+        d->doStart();
+    });
+}
+
+void ArchiveJob::setBatchSize(int size)
+{
+    d->mBatchSize = std::max(size, 1);
+}
+
+int ArchiveJob::batchSize() const
+{
+    return d->mBatchSize;
+}
+
+void ArchiveJob::setMaxConcurrentBatches(int count)
+{
+    d->mMaxConcurrentBatches = std::max(count, 1);
+}
+
+int ArchiveJob::maxConcurrentBatches() const
+{
+    return d->mMaxConcurrentBatches;
+}
+
+bool ArchiveJob::doKill()
+{
+    d->mKilled = true;
+    if (d->mDeleting) {
+        // Batches already handed to the IncidenceChanger can't be stopped, the others are skipped.
+        // Only the deletions confirmed so far are announced.
+        if (d->mDeletedCount > 0) {
+            Q_EMIT eventsDeleted();
+        }
+        return true;
+    }
+    if (d->mSubJob) {
+        d->mSubJob->kill(KJob::Quietly);
+    }
+    d->mWatcher.cancel();
+    return true;
+}
+
+#include "moc_archivejob.cpp"
@@ -0,0 +1,111 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#pragma once
+
+#include "calendarsupport_export.h"
+
+#include <Akonadi/ETMCalendar>
+#include <KCalendarCore/Incidence>
+
+#include <KJob>
+
+#include <QUrl>
+
+#include <memory>
+
+class QWidget;
+
+namespace Akonadi
+{
+class IncidenceChanger;
+}
+
+namespace CalendarSupport
+{
+class ArchiveJobPrivate;
+
+/*!
+ * \class CalendarSupport::ArchiveJob
+ * \inmodule CalendarSupport
+ * \inheaderfile CalendarSupport/ArchiveJob
+ *
+ * Deletes a set of incidences from the calendar, after saving them to an
+ * archive file if requested, without blocking the GUI.
+ *
+ * The archive file is downloaded, merged and written in a worker thread and
+ * with asynchronous KIO jobs. The incidences are then handed to the
+ * IncidenceChanger in batches, with a limited number of batches being deleted
+ * at the same time. The job reports its progress as a percentage and the
+ * number of incidences deleted so far. When killed, no further batches are
+ * handed to the IncidenceChanger. The batches it already has are still deleted
+ * after the kill, but the job no longer reports them: eventsDeleted() is only
+ * emitted by the kill if some deletions were confirmed before it.
+ *
+ * The job finishes, and eventsDeleted() is emitted, once the IncidenceChanger
+ * has confirmed the deletion.
+ *
+ * \since 6.9.0
+ */
+class CALENDARSUPPORT_EXPORT ArchiveJob : public KJob
+{
+    Q_OBJECT
+public:
+    enum Action {
+        Delete, ///< Delete the incidences
+        Archive, ///< Save the incidences to the archive file, then delete them
+    };
+
+    /*!
+     * Creates a job applying \a action to \a incidences of \a calendar.
+     * \a widget is used as parent for the windows of KIO and of the
+     * IncidenceChanger.
+     */
+    ArchiveJob(Action action,
+               const Akonadi::ETMCalendar::Ptr &calendar,
+               Akonadi::IncidenceChanger *changer,
+               const KCalendarCore::Incidence::List &incidences,
+               QWidget *widget,
+               QObject *parent = nullptr);
+    ~ArchiveJob() override;
+
+    /*!
+     * Sets the file the incidences are archived to, which may be remote.
+     * Existing archive files are merged with the archived incidences.
+     */
+    void setArchiveUrl(const QUrl &url);
+    [[nodiscard]] QUrl archiveUrl() const;
+
+    /*!
+     * Sets the number of incidences deleted by one IncidenceChanger call to \a size.
+     * The default is 100.
+     */
+    void setBatchSize(int size);
+    [[nodiscard]] int batchSize() const;
+
+    /*!
+     * Sets the number of batches that may be deleted at the same time to \a count.
+     * The default is 2.
+     */
+    void setMaxConcurrentBatches(int count);
+    [[nodiscard]] int maxConcurrentBatches() const;
+
+    void start() override;
+
+Q_SIGNALS:
+    /*!
+     * Emitted once the incidences were deleted from the calendar.
+     */
+    void eventsDeleted();
+
+protected:
+    bool doKill() override;
+
+private:
+    friend class ArchiveJobPrivate;
+    std::unique_ptr<ArchiveJobPrivate> const d;
+};
+}
@@ -8,9 +8,13 @@
 
 #include "cellitem.h"
 
-#include "calendarsupport_debug.h"
 #include <KLocalizedString>
 
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <vector>
+
 using namespace CalendarSupport;
 
 void CellItem::setSubCells(int v)
@@ -38,6 +42,16 @@ QString CellItem::label() const
     return xi18n("<placeholder>undefined</placeholder>");
 }
 
+qint64 CellItem::extentStart() const
+{
+    return 0;
+}
+
+qint64 CellItem::extentEnd() const
+{
+    return -1;
+}
+
 QList<CellItem *> CellItem::placeItem(const QList<CellItem *> &cells, CellItem *placeItem)
 {
     int maxSubCells = 0;
@@ -45,11 +59,12 @@ QList<CellItem *> CellItem::placeItem(const QList<CellItem *> &cells, CellItem *
 
     // Find all items that overlap placeItem, the items that overlaps them, and so on.
     QList<CellItem *> overlappingItems{placeItem};
+    QSet<const CellItem *> seenItems{placeItem};
     for (int i = 0; i < overlappingItems.count(); i++) {
         const auto checkItem = overlappingItems.at(i);
         for (const auto item : cells) {
-            if (item->overlaps(checkItem) && !overlappingItems.contains(item)) {
-                qCDebug(CALENDARSUPPORT_LOG) << item->label() << "overlaps" << checkItem->label();
+            if (!seenItems.contains(item) && item->overlaps(checkItem)) {
+                seenItems.insert(item);
                 overlappingItems.append(item);
                 if (item->subCell() >= maxSubCells) {
                     maxSubCells = item->subCells();
@@ -87,3 +102,76 @@ QList<CellItem *> CellItem::placeItem(const QList<CellItem *> &cells, CellItem *
 
     return overlappingItems;
 }
+
+void CellItem::placeItems(const QList<CellItem *> &cells)
+{
+    struct Extent {
+        qint64 start;
+        qint64 end;
+        CellItem *item;
+    };
+
+    std::vector<Extent> extents;
+    extents.reserve(cells.size());
+    for (CellItem *item : cells) {
+        const qint64 start = item->extentStart();
+        const qint64 end = item->extentEnd();
+        if (end < start) {
+            // Not an interval, we can only compare items pairwise.
+            for (CellItem *cell : cells) {
+                placeItem(cells, cell);
+            }
+            return;
+        }
+        extents.push_back({start, end, item});
+    }
+
+    // Items starting at the same time keep their order, as with placeItem() they take
+    // their sub-cells in the order they were passed. Only empty items go first, as they
+    // don't overlap the others starting with them and must be done with before those
+    // take a sub-cell.
+    std::stable_sort(extents.begin(), extents.end(), [](const Extent &a, const Extent &b) {
+        return a.start < b.start || (a.start == b.start && a.end == a.start && b.end != b.start);
+    });
+
+    // Sweep over the items in order of their start. The items that are still running are
+    // kept by their end together with their sub-cell, which goes back to the free sub-cells
+    // once the item has ended. When no item is running any more, the group of overlapping
+    // items is complete and all of them get the number of sub-cells the group used.
+    using RunningItem = std::pair<qint64, int>;
+    std::priority_queue<RunningItem, std::vector<RunningItem>, std::greater<>> running;
+    std::priority_queue<int, std::vector<int>, std::greater<>> freeSubCells;
+    int usedSubCells = 0;
+    size_t groupStart = 0;
+
+    const auto finishGroup = [&](size_t groupEnd) {
+        for (size_t i = groupStart; i < groupEnd; ++i) {
+            extents[i].item->setSubCells(usedSubCells);
+        }
+        groupStart = groupEnd;
+        usedSubCells = 0;
+        freeSubCells = {};
+    };
+
+    for (size_t i = 0; i < extents.size(); ++i) {
+        const Extent &extent = extents[i];
+        while (!running.empty() && running.top().first <= extent.start) {
+            freeSubCells.push(running.top().second);
+            running.pop();
+        }
+        if (running.empty() && i > groupStart) {
+            finishGroup(i);
+        }
+
+        int subCell;
+        if (freeSubCells.empty()) {
+            subCell = usedSubCells++;
+        } else {
+            subCell = freeSubCells.top();
+            freeSubCells.pop();
+        }
+        extent.item->setSubCell(subCell);
+        running.emplace(extent.end, subCell);
+    }
+    finishGroup(extents.size());
+}
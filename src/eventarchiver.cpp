@@ -9,55 +9,32 @@
 #include "eventarchiver.h"
 using namespace Qt::Literals::StringLiterals;
 
+#include "archivejob.h"
 #include "kcalprefs.h"
 
-#include <Akonadi/CalendarUtils>
-#include <Akonadi/IncidenceChanger>
-
-#include <KCalendarCore/Exceptions>
-#include <KCalendarCore/FileStorage>
 #include <KCalendarCore/ICalFormat>
-#include <KCalendarCore/MemoryCalendar>
-
-#if KCALENDARCORE_VERSION < QT_VERSION_CHECK(6, 30, 0)
-#include <KCalUtils/Stringify>
-#endif
 
 #include "calendarsupport_debug.h"
-#include <KIO/FileCopyJob>
-#include <KIO/StatJob>
-#include <KJobWidgets>
+#include <KIO/JobTracker>
+#include <KJobTrackerInterface>
 #include <KLocalizedString>
 #include <KMessageBox>
 
+#include <QHash>
 #include <QLocale>
-#include <QTemporaryFile>
+#include <QPointer>
 #include <QTimeZone>
 
+#include <algorithm>
+#include <vector>
+
 using namespace KCalendarCore;
 using namespace CalendarSupport;
 
-namespace
-{
-class GroupwareScoppedDisabler
-{
-public:
-    explicit GroupwareScoppedDisabler(Akonadi::IncidenceChanger *changer)
-        : m_changer(changer)
-    {
-        m_wasEnabled = m_changer->groupwareCommunication();
-        m_changer->setGroupwareCommunication(false);
-    }
-
-    ~GroupwareScoppedDisabler()
-    {
-        m_changer->setGroupwareCommunication(m_wasEnabled);
-    }
-
-    bool m_wasEnabled = false;
-    Akonadi::IncidenceChanger *const m_changer;
-};
-}
+// The number of incidences serialized to estimate the size of an archive.
+static constexpr qsizetype PreviewSampleSize = 64;
+// The number of items listed when asking whether to delete them.
+static constexpr qsizetype MaxConfirmationListSize = 200;
 
 EventArchiver::EventArchiver(QObject *parent)
     : QObject(parent)
@@ -68,62 +45,95 @@ EventArchiver::~EventArchiver() = default;
 
 void EventArchiver::runOnce(const Akonadi::ETMCalendar::Ptr &calendar, Akonadi::IncidenceChanger *changer, QDate limitDate, QWidget *widget)
 {
-    run(calendar, changer, limitDate, widget, true, true);
+    if (!run(calendar, changer, limitDate, widget, true, true)) {
+        Q_EMIT finished();
+    }
 }
 
 void EventArchiver::runAuto(const Akonadi::ETMCalendar::Ptr &calendar, Akonadi::IncidenceChanger *changer, QWidget *widget, bool withGUI)
 {
-    QDate limitDate(QDate::currentDate());
-    const int expiryTime = KCalPrefs::instance()->mExpiryTime;
-    switch (KCalPrefs::instance()->mExpiryUnit) {
+    const QDate limitDate = autoArchiveLimitDate(KCalPrefs::instance()->mExpiryTime, KCalPrefs::instance()->mExpiryUnit);
+    if (!limitDate.isValid() || !run(calendar, changer, limitDate, widget, withGUI, false)) {
+        Q_EMIT finished();
+    }
+}
+
+QDate EventArchiver::autoArchiveLimitDate(int expiryTime, int expiryUnit)
+{
+    const QDate today(QDate::currentDate());
+    switch (expiryUnit) {
     case KCalPrefs::UnitDays: // Days
-        limitDate = limitDate.addDays(-expiryTime);
-        break;
+        return today.addDays(-expiryTime);
     case KCalPrefs::UnitWeeks: // Weeks
-        limitDate = limitDate.addDays(-expiryTime * 7);
-        break;
+        return today.addDays(-expiryTime * 7);
     case KCalPrefs::UnitMonths: // Months
-        limitDate = limitDate.addMonths(-expiryTime);
-        break;
+        return today.addMonths(-expiryTime);
     default:
-        return;
+        return {};
     }
-    run(calendar, changer, limitDate, widget, withGUI, false);
 }
 
-void EventArchiver::run(const Akonadi::ETMCalendar::Ptr &calendar,
-                        Akonadi::IncidenceChanger *changer,
-                        QDate limitDate,
-                        QWidget *widget,
-                        bool withGUI,
-                        bool errorIfNone)
+KCalendarCore::Incidence::List EventArchiver::collectIncidences(const Akonadi::ETMCalendar::Ptr &calendar, QDate limitDate, bool events, bool todos)
 {
-    GroupwareScoppedDisabler const disabler(changer); // Disables groupware communication temporarily
-
     // We need to use rawEvents, otherwise events hidden by filters will not be archived.
-    KCalendarCore::Event::List events;
-    KCalendarCore::Todo::List todos;
+    KCalendarCore::Event::List eventList;
+    KCalendarCore::Todo::List todoList;
     KCalendarCore::Journal::List const journals;
 
-    if (KCalPrefs::instance()->mArchiveEvents) {
-        events = calendar->rawEvents(QDate(1769, 12, 1),
-                                     // #29555, also advertised by the "limitDate not included" in the class docu
-                                     limitDate.addDays(-1),
-                                     QTimeZone::systemTimeZone(),
-                                     true);
+    if (events) {
+        eventList = calendar->rawEvents(QDate(1769, 12, 1),
+                                        // #29555, also advertised by the "limitDate not included" in the class docu
+                                        limitDate.addDays(-1),
+                                        QTimeZone::systemTimeZone(),
+                                        true);
+    }
+    if (todos) {
+        todoList = archivableTodos(calendar->rawTodos(), limitDate);
     }
-    if (KCalPrefs::instance()->mArchiveTodos) {
-        const KCalendarCore::Todo::List rawTodos = calendar->rawTodos();
 
-        for (const KCalendarCore::Todo::Ptr &todo : rawTodos) {
-            Q_ASSERT(todo);
-            if (isSubTreeComplete(calendar, todo, limitDate)) {
-                todos.append(todo);
-            }
+    return calendar->mergeIncidenceList(eventList, todoList, journals);
+}
+
+EventArchiver::Preview EventArchiver::preview(const Akonadi::ETMCalendar::Ptr &calendar, QDate limitDate, bool events, bool todos)
+{
+    Preview result;
+    const KCalendarCore::Incidence::List incidences = collectIncidences(calendar, limitDate, events, todos);
+    for (const KCalendarCore::Incidence::Ptr &incidence : incidences) {
+        Preview::Counts &counts = result.collections[calendar->item(incidence).parentCollection().id()];
+        if (incidence->type() == KCalendarCore::Incidence::TypeTodo) {
+            ++counts.todos;
+            ++result.todos;
+        } else {
+            ++counts.events;
+            ++result.events;
         }
     }
 
-    const KCalendarCore::Incidence::List incidences = calendar->mergeIncidenceList(events, todos, journals);
+    // Serializing every incidence would take about as long as archiving them, so
+    // extrapolate the size from an evenly spread sample.
+    if (!incidences.isEmpty()) {
+        KCalendarCore::ICalFormat format;
+        const qsizetype step = std::max<qsizetype>(1, incidences.count() / PreviewSampleSize);
+        qint64 sampleSize = 0;
+        qint64 samples = 0;
+        for (qsizetype i = 0; i < incidences.count(); i += step) {
+            sampleSize += format.toString(incidences.at(i)).toUtf8().size();
+            ++samples;
+        }
+        result.estimatedSize = sampleSize * incidences.count() / samples;
+    }
+    return result;
+}
+
+bool EventArchiver::run(const Akonadi::ETMCalendar::Ptr &calendar,
+                        Akonadi::IncidenceChanger *changer,
+                        QDate limitDate,
+                        QWidget *widget,
+                        bool withGUI,
+                        bool errorIfNone)
+{
+    const KCalendarCore::Incidence::List incidences =
+        collectIncidences(calendar, limitDate, KCalPrefs::instance()->mArchiveEvents, KCalPrefs::instance()->mArchiveTodos);
 
     qCDebug(CALENDARSUPPORT_LOG) << "archiving incidences before" << limitDate << " ->" << incidences.count() << " incidences found.";
     if (incidences.isEmpty()) {
@@ -133,32 +143,40 @@ void EventArchiver::run(const Akonadi::ETMCalendar::Ptr &calendar,
                                      i18nc("@title:window", "Archive"),
                                      u"ArchiverNoIncidences"_s);
         }
-        return;
+        return false;
     }
 
     switch (KCalPrefs::instance()->mArchiveAction) {
     case KCalPrefs::actionDelete:
-        deleteIncidences(changer, limitDate, widget, calendar->itemList(incidences), withGUI);
-        break;
+        return deleteIncidences(calendar, changer, limitDate, widget, incidences, withGUI);
     case KCalPrefs::actionArchive:
         archiveIncidences(calendar, changer, limitDate, widget, incidences, withGUI);
-        break;
+        return true;
     default:
-        break;
+        return false;
     }
 }
 
-void EventArchiver::deleteIncidences(Akonadi::IncidenceChanger *changer, QDate limitDate, QWidget *widget, const Akonadi::Item::List &items, bool withGUI)
+bool EventArchiver::deleteIncidences(const Akonadi::ETMCalendar::Ptr &calendar,
+                                     Akonadi::IncidenceChanger *changer,
+                                     QDate limitDate,
+                                     QWidget *widget,
+                                     const KCalendarCore::Incidence::List &incidences,
+                                     bool withGUI)
 {
-    QStringList incidenceStrs;
-    Akonadi::Item::List::ConstIterator it;
-    Akonadi::Item::List::ConstIterator const end(items.constEnd());
-    incidenceStrs.reserve(items.count());
-    for (it = items.constBegin(); it != end; ++it) {
-        incidenceStrs.append(Akonadi::CalendarUtils::incidence(*it)->summary());
-    }
-
     if (withGUI) {
+        // Listing thousands of summaries helps nobody and takes a lot of memory, so only
+        // the first ones are listed.
+        const qsizetype listed = std::min(incidences.count(), MaxConfirmationListSize);
+        QStringList incidenceStrs;
+        incidenceStrs.reserve(listed + 1);
+        for (qsizetype i = 0; i < listed; ++i) {
+            incidenceStrs.append(incidences.at(i)->summary());
+        }
+        if (incidences.count() > listed) {
+            incidenceStrs.append(i18np("…and 1 more item", "…and %1 more items", incidences.count() - listed));
+        }
+
         const int result = KMessageBox::warningContinueCancelList(widget,
                                                                   i18n("Delete all items before %1 without saving?\n"
                                                                        "The following items will be deleted:",
@@ -167,14 +185,12 @@ void EventArchiver::deleteIncidences(Akonadi::IncidenceChanger *changer, QDate l
                                                                   i18nc("@title:window", "Delete Old Items"),
                                                                   KStandardGuiItem::del());
         if (result != KMessageBox::Continue) {
-            return;
+            return false;
         }
     }
 
-    changer->deleteIncidences(items, /**parent=*/widget);
-
-    // TODO: Q_EMIT only after hearing back from incidence changer
-    Q_EMIT eventsDeleted();
+    startJob(new ArchiveJob(ArchiveJob::Delete, calendar, changer, incidences, widget), widget, withGUI);
+    return true;
 }
 
 void EventArchiver::archiveIncidences(const Akonadi::ETMCalendar::Ptr &calendar,
@@ -185,159 +201,113 @@ void EventArchiver::archiveIncidences(const Akonadi::ETMCalendar::Ptr &calendar,
                                       bool withGUI)
 {
     Q_UNUSED(limitDate)
-    Q_UNUSED(withGUI)
-
-    FileStorage storage(calendar);
-
-    QString tmpFileName;
-    // KSaveFile cannot be called with an open File Handle on Windows.
-    // So we use QTemporaryFile only to generate a unique filename
-    // and then close/delete the file again. This file must be deleted
-    // here.
-    {
-        QTemporaryFile tmpFile;
-        if (!tmpFile.open()) {
-            qCWarning(CALENDARSUPPORT_LOG) << "Impossible to open file";
-            return;
-        }
-        tmpFileName = tmpFile.fileName();
-    }
-    // Save current calendar to disk
-    storage.setFileName(tmpFileName);
-    if (!storage.save()) {
-        qCDebug(CALENDARSUPPORT_LOG) << "Can't save calendar to temp file";
-        return;
-    }
 
-    // Duplicate current calendar by loading in new calendar object
-    MemoryCalendar::Ptr const archiveCalendar(new MemoryCalendar(QTimeZone::systemTimeZone()));
-
-    FileStorage archiveStore(archiveCalendar);
-    archiveStore.setFileName(tmpFileName);
-    auto format = new ICalFormat();
-    archiveStore.setSaveFormat(format);
-    if (!archiveStore.load()) {
-        qCDebug(CALENDARSUPPORT_LOG) << "Can't load calendar from temp file";
-        QFile::remove(tmpFileName);
-        return;
-    }
+    auto job = new ArchiveJob(ArchiveJob::Archive, calendar, changer, incidences, widget);
+    job->setArchiveUrl(QUrl(KCalPrefs::instance()->mArchiveFile));
+    startJob(job, widget, withGUI);
+}
 
-    // Strip active events from calendar so that only events to be archived
-    // remain. This is not really efficient, but there is no other easy way.
-    QStringList uids;
-    Incidence::List allIncidences = archiveCalendar->rawIncidences();
-    uids.reserve(incidences.count());
-    for (const KCalendarCore::Incidence::Ptr &incidence : std::as_const(incidences)) {
-        uids.append(incidence->uid());
-    }
-    for (const KCalendarCore::Incidence::Ptr &incidence : std::as_const(allIncidences)) {
-        if (!uids.contains(incidence->uid())) {
-            archiveCalendar->deleteIncidence(incidence);
+void EventArchiver::startJob(ArchiveJob *job, QWidget *widget, bool withGUI)
+{
+    connect(job, &ArchiveJob::eventsDeleted, this, &EventArchiver::eventsDeleted);
+    connect(job, &KJob::result, this, &EventArchiver::finished);
+    // Errors are reported even without GUI, like "cannot save" always was.
+    connect(job, &KJob::result, job, [widget = QPointer<QWidget>(widget)](KJob *job) {
+        if (job->error() && job->error() != KJob::KilledJobError) {
+            KMessageBox::error(widget, job->errorString());
         }
+    });
+    if (withGUI) {
+        KIO::getJobTracker()->registerJob(job);
     }
+    job->start();
+}
 
-    // Get or create the archive file
-    const QUrl archiveURL(KCalPrefs::instance()->mArchiveFile);
-    QString archiveFile;
-    QTemporaryFile const downloadTempFile;
-
-    bool fileExists = false;
-    if (archiveURL.isLocalFile()) {
-        fileExists = QFile::exists(archiveURL.toLocalFile());
-    } else {
-        auto job = KIO::stat(archiveURL, KIO::StatJob::SourceSide, KIO::StatBasic);
-
-        KJobWidgets::setWindow(job, widget);
-        fileExists = job->exec();
-    }
-
-    if (fileExists) {
-        archiveFile = downloadTempFile.fileName();
-        auto job = KIO::file_copy(archiveURL, QUrl::fromLocalFile(archiveFile));
-        KJobWidgets::setWindow(job, widget);
-        if (!job->exec()) {
-            qCDebug(CALENDARSUPPORT_LOG) << "Can't download archive file";
-            QFile::remove(tmpFileName);
-            return;
-        }
-        // Merge with events to be archived.
-        archiveStore.setFileName(archiveFile);
-        if (!archiveStore.load()) {
-            qCDebug(CALENDARSUPPORT_LOG) << "Can't merge with archive file";
-            QFile::remove(tmpFileName);
-            return;
+KCalendarCore::Todo::List EventArchiver::archivableTodos(const KCalendarCore::Todo::List &todos, QDate limitDate)
+{
+    const auto isCompletedBefore = [limitDate](const Todo::Ptr &todo) {
+        return todo->isCompleted() && todo->completed().date() < limitDate;
+    };
+
+    // The sub-to-dos of each uid. Recurrence exceptions share the uid of their to-do,
+    // so they also share its sub-to-dos.
+    QHash<QString, Todo::List> children;
+    for (const Todo::Ptr &todo : todos) {
+        Q_ASSERT(todo);
+        const QString parentUid = todo->relatedTo();
+        if (!parentUid.isEmpty()) {
+            children[parentUid].append(todo);
         }
-    } else {
-        archiveFile = tmpFileName;
     }
 
-    // Save archive calendar
-    if (!archiveStore.save()) {
-        QString errmess;
-        if (format->exception()) {
-#if KCALENDARCORE_VERSION < QT_VERSION_CHECK(6, 30, 0)
-            errmess = KCalUtils::Stringify::errorMessage(*format->exception());
-#else
-            errmess = format->exception()->errorMessage();
-#endif
-        } else {
-            errmess = i18nc("save failure cause unknown", "Reason unknown");
+    // Whether all sub-to-dos of a uid, recursively, were completed before limitDate.
+    enum class State : quint8 {
+        Visiting,
+        Complete,
+        Incomplete,
+    };
+    QHash<QString, State> states;
+    states.reserve(todos.count());
+
+    struct Frame {
+        QString uid;
+        const Todo::List *children;
+        qsizetype next;
+        bool complete;
+    };
+    const Todo::List noChildren;
+    const auto childrenOf = [&children, &noChildren](const QString &uid) {
+        const auto it = children.constFind(uid);
+        return it != children.cend() ? &*it : &noChildren;
+    };
+
+    // Walks the sub-tree below uid depth first, without recursion, and records the
+    // result of each uid on the way back up.
+    const auto subTreeComplete = [&](const QString &uid) {
+        const auto known = states.constFind(uid);
+        if (known != states.cend()) {
+            return *known == State::Complete;
         }
-        KMessageBox::error(widget, i18n("Cannot write archive file %1. %2", archiveStore.fileName(), errmess));
-        QFile::remove(tmpFileName);
-        return;
-    }
-
-    // Upload if necessary
-    const QUrl srcUrl = QUrl::fromLocalFile(archiveFile);
-    if (srcUrl != archiveURL) {
-        auto job = KIO::file_copy(QUrl::fromLocalFile(archiveFile), archiveURL);
-        KJobWidgets::setWindow(job, widget);
-        if (!job->exec()) {
-            KMessageBox::error(widget, i18n("Cannot write archive. %1", job->errorString()));
-            QFile::remove(tmpFileName);
-            return;
+        std::vector<Frame> stack;
+        states.insert(uid, State::Visiting);
+        stack.push_back({uid, childrenOf(uid), 0, true});
+        while (!stack.empty()) {
+            Frame &frame = stack.back();
+            if (frame.complete && frame.next < frame.children->count()) {
+                const Todo::Ptr &child = frame.children->at(frame.next++);
+                if (!isCompletedBefore(child)) {
+                    frame.complete = false;
+                    continue;
+                }
+                const auto childState = states.constFind(child->uid());
+                if (childState == states.cend()) {
+                    states.insert(child->uid(), State::Visiting);
+                    stack.push_back({child->uid(), childrenOf(child->uid()), 0, true});
+                } else if (*childState == State::Visiting) {
+                    qCWarning(CALENDARSUPPORT_LOG) << "To-do hierarchy loop detected!";
+                    frame.complete = false;
+                } else if (*childState == State::Incomplete) {
+                    frame.complete = false;
+                }
+                continue;
+            }
+            const bool complete = frame.complete;
+            states[frame.uid] = complete ? State::Complete : State::Incomplete;
+            stack.pop_back();
+            if (!complete && !stack.empty()) {
+                stack.back().complete = false;
+            }
         }
-    }
-
-    QFile::remove(tmpFileName);
-
-    // We don't want it to ask to send invitations for each incidence.
-    changer->startAtomicOperation(i18n("Archiving events"));
-
-    // Delete archived events from calendar
-    const Akonadi::Item::List items = calendar->itemList(incidences);
-    for (const Akonadi::Item &item : items) {
-        changer->deleteIncidence(item, widget);
-    } // TODO: Q_EMIT only after hearing back from incidence changer
-    changer->endAtomicOperation();
-
-    Q_EMIT eventsDeleted();
-}
+        return states.value(uid) == State::Complete;
+    };
 
-bool EventArchiver::isSubTreeComplete(const Akonadi::ETMCalendar::Ptr &calendar, const Todo::Ptr &todo, QDate limitDate, QStringList checkedUids) const
-{
-    if (!todo->isCompleted() || todo->completed().date() >= limitDate) {
-        return false;
-    }
-
-    // This QList is only to prevent infinite recursion
-    if (checkedUids.contains(todo->uid())) {
-        // Probably will never happen, calendar.cpp checks for this
-        qCWarning(CALENDARSUPPORT_LOG) << "To-do hierarchy loop detected!";
-        return false;
-    }
-
-    checkedUids.append(todo->uid());
-    const KCalendarCore::Incidence::List children = calendar->childIncidences(todo->uid());
-    for (const KCalendarCore::Incidence::Ptr &incidence : children) {
-        const Todo::Ptr t = incidence.dynamicCast<KCalendarCore::Todo>();
-        if (t && !isSubTreeComplete(calendar, t, limitDate, checkedUids)) {
-            return false;
+    Todo::List archivable;
+    for (const Todo::Ptr &todo : todos) {
+        if (isCompletedBefore(todo) && subTreeComplete(todo->uid())) {
+            archivable.append(todo);
         }
     }
-
-    return true;
+    return archivable;
 }
 
 #include "moc_eventarchiver.cpp"
@@ -15,6 +15,7 @@
 #include <KCalendarCore/Event>
 #include <KCalendarCore/Todo>
 
+#include <QHash>
 #include <QObject>
 
 class QDate;
@@ -26,6 +27,8 @@ class IncidenceChanger;
 
 namespace CalendarSupport
 {
+class ArchiveJob;
+
 /*!
  * \class CalendarSupport::EventArchiver
  * \inmodule CalendarSupport
@@ -66,17 +69,81 @@ public:
      */
     void runAuto(const Akonadi::ETMCalendar::Ptr &calendar, Akonadi::IncidenceChanger *changer, QWidget *widget, bool withGUI);
 
+    /*!
+     * Returns the to-dos of \a todos that can be archived at \a limitDate, i.e. those which,
+     * together with all their sub-to-dos in \a todos, were completed before \a limitDate.
+     *
+     * The to-do hierarchy is walked once, so this takes linear time. To-dos that are part
+     * of a hierarchy loop are never archivable.
+     *
+     * Sub-to-dos missing from \a todos are not taken into account, so \a todos should
+     * contain all to-dos of the calendar.
+     * \since 6.9.0
+     */
+    static KCalendarCore::Todo::List archivableTodos(const KCalendarCore::Todo::List &todos, QDate limitDate);
+
+    /*!
+     * \brief What archiving at a given date would process, see preview().
+     * \since 6.9.0
+     */
+    struct Preview {
+        struct Counts {
+            int events = 0;
+            int todos = 0;
+        };
+        /*! The number of events and to-dos per collection. */
+        QHash<Akonadi::Collection::Id, Counts> collections;
+        int events = 0;
+        int todos = 0;
+        /*! The estimated size of the incidences in iCalendar format, in bytes. */
+        qint64 estimatedSize = 0;
+    };
+
+    /*!
+     * Counts the events and to-dos of \a calendar that archiving at \a limitDate would
+     * process, and estimates how much space they take in the archive file. Nothing is
+     * written or deleted.
+     * \a events and \a todos tell whether events and completed to-dos are archived.
+     * \since 6.9.0
+     */
+    static Preview preview(const Akonadi::ETMCalendar::Ptr &calendar, QDate limitDate, bool events, bool todos);
+
+    /*!
+     * Returns the limit date of automatic archiving for items older than \a expiryTime
+     * in \a expiryUnit, one of KCalPrefs' expiry units, or an invalid date if the unit
+     * is unknown.
+     * \since 6.9.0
+     */
+    static QDate autoArchiveLimitDate(int expiryTime, int expiryUnit);
+
 Q_SIGNALS:
     /*!
+     * Emitted once the IncidenceChanger has deleted the expired incidences.
+     * Archiving and deleting run in an ArchiveJob, after runOnce() or runAuto() returned.
      */
     void eventsDeleted();
 
+    /*!
+     * Emitted once runOnce() or runAuto() is done: after its ArchiveJob finished, or
+     * right away if there was nothing to do or the user canceled.
+     * \since 6.9.0
+     */
+    void finished();
+
 private:
-    CALENDARSUPPORT_NO_EXPORT void
+    CALENDARSUPPORT_NO_EXPORT static KCalendarCore::Incidence::List
+    collectIncidences(const Akonadi::ETMCalendar::Ptr &calendar, QDate limitDate, bool events, bool todos);
+
+    // Returns whether an ArchiveJob was started, which emits finished() once done
+    CALENDARSUPPORT_NO_EXPORT bool
     run(const Akonadi::ETMCalendar::Ptr &calendar, Akonadi::IncidenceChanger *changer, QDate limitDate, QWidget *widget, bool withGUI, bool errorIfNone);
 
-    CALENDARSUPPORT_NO_EXPORT void
-    deleteIncidences(Akonadi::IncidenceChanger *changer, QDate limitDate, QWidget *widget, const Akonadi::Item::List &items, bool withGUI);
+    CALENDARSUPPORT_NO_EXPORT bool deleteIncidences(const Akonadi::ETMCalendar::Ptr &calendar,
+                                                    Akonadi::IncidenceChanger *changer,
+                                                    QDate limitDate,
+                                                    QWidget *widget,
+                                                    const KCalendarCore::Incidence::List &incidences,
+                                                    bool withGUI);
 
     CALENDARSUPPORT_NO_EXPORT void archiveIncidences(const Akonadi::ETMCalendar::Ptr &calendar,
                                                      Akonadi::IncidenceChanger *changer,
@@ -85,16 +152,6 @@ private:
                                                      const KCalendarCore::Incidence::List &incidences,
                                                      bool withGUI);
 
-    /*!
-     * Checks if all to-dos under \a todo and including \a todo were completed before \a limitDate.
-     * If not, we can't archive this to-do.
-     * \a todo root of the sub-tree we are checking
-     * \a limitDate
-     * \a checkedUids used internally to prevent infinite recursion due to invalid calendar files
-     */
-    CALENDARSUPPORT_NO_EXPORT bool isSubTreeComplete(const Akonadi::ETMCalendar::Ptr &calendar,
-                                                     const KCalendarCore::Todo::Ptr &todo,
-                                                     QDate limitDate,
-                                                     QStringList checkedUids = QStringList()) const;
+    CALENDARSUPPORT_NO_EXPORT void startJob(ArchiveJob *job, QWidget *widget, bool withGUI);
 };
 }
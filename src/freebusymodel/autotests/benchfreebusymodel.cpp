@@ -0,0 +1,236 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+// Benchmarks of the free/busy models with synthetic data, for catching scaling
+// regressions of the scheduling dialog. Each benchmark spreads 10000 busy periods
+// over 10, 100 or 1000 attendees. Run with e.g. "-o results.csv,csv" or
+// "-o results.xml,xml" for machine-readable results.
+
+#include "benchfreebusymodel.h"
+#include "../freebusycache.h"
+#include "../freebusycalendar.h"
+#include "../freebusyitem.h"
+#include "../freebusyitemmodel.h"
+#include "../freeperiodmodel.h"
+
+#include <KCalendarCore/Attendee>
+#include <KCalendarCore/Calendar>
+
+#include <QStandardPaths>
+#include <QTest>
+
+using namespace CalendarSupport;
+using namespace Qt::Literals::StringLiterals;
+
+QTEST_GUILESS_MAIN(FreeBusyModelBenchmark)
+
+static constexpr int PeriodCount = 10000;
+
+// Returns count half hour busy periods, one per hour, starting offset minutes after
+// the start of the first period
+static KCalendarCore::FreeBusy::Ptr makeFreeBusy(int count, int offset = 0)
+{
+    const QDateTime start = QDateTime(QDate(2026, 1, 5), QTime(8, 0), QTimeZone::UTC).addSecs(offset * 60);
+    KCalendarCore::FreeBusyPeriod::List periods;
+    periods.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        KCalendarCore::FreeBusyPeriod period(start.addSecs(i * 3600), KCalendarCore::Duration(30 * 60));
+        period.setType(i % 4 == 0 ? KCalendarCore::FreeBusyPeriod::BusyTentative : KCalendarCore::FreeBusyPeriod::Busy);
+        periods.append(period);
+    }
+    return KCalendarCore::FreeBusy::Ptr(new KCalendarCore::FreeBusy(periods));
+}
+
+static QString email(int attendee)
+{
+    return u"attendee%1@example.com"_s.arg(attendee);
+}
+
+// Returns the attendees, with periods busy periods each, or without any if periods is 0
+static QList<FreeBusyItem::Ptr> makeItems(int attendees, int periods)
+{
+    QList<FreeBusyItem::Ptr> items;
+    items.reserve(attendees);
+    for (int i = 0; i < attendees; ++i) {
+        FreeBusyItem::Ptr const item(new FreeBusyItem(KCalendarCore::Attendee(u"Attendee %1"_s.arg(i), email(i)), nullptr));
+        item->setFreeBusy(makeFreeBusy(periods));
+        items.append(item);
+    }
+    return items;
+}
+
+static void addAttendeeRows()
+{
+    QTest::addColumn<int>("attendees");
+    for (int const attendees : {10, 100, 1000}) {
+        QTest::addRow("%d attendees", attendees) << attendees;
+    }
+}
+
+void FreeBusyModelBenchmark::initTestCase()
+{
+    // addItems() looks up the free/busy cache, which must not be the user's
+    QStandardPaths::setTestModeEnabled(true);
+    FreeBusyCache::instance()->clear();
+}
+
+void FreeBusyModelBenchmark::benchmarkAddItem_data()
+{
+    addAttendeeRows();
+}
+
+void FreeBusyModelBenchmark::benchmarkAddItem()
+{
+    QFETCH(int, attendees);
+    const QList<FreeBusyItem::Ptr> items = makeItems(attendees, PeriodCount / attendees);
+
+    QBENCHMARK {
+        FreeBusyItemModel model;
+        for (const FreeBusyItem::Ptr &item : items) {
+            model.addItem(item);
+        }
+    }
+}
+
+void FreeBusyModelBenchmark::benchmarkAddItems_data()
+{
+    addAttendeeRows();
+}
+
+void FreeBusyModelBenchmark::benchmarkAddItems()
+{
+    QFETCH(int, attendees);
+    const QList<FreeBusyItem::Ptr> items = makeItems(attendees, PeriodCount / attendees);
+
+    QBENCHMARK {
+        FreeBusyItemModel model;
+        model.addItems(items);
+    }
+}
+
+void FreeBusyModelBenchmark::benchmarkInsertFreeBusy_data()
+{
+    addAttendeeRows();
+}
+
+void FreeBusyModelBenchmark::benchmarkInsertFreeBusy()
+{
+    QFETCH(int, attendees);
+    const QList<FreeBusyItem::Ptr> items = makeItems(attendees, 0);
+    const KCalendarCore::FreeBusy::Ptr fb = makeFreeBusy(PeriodCount / attendees);
+
+    // Adding the attendees without periods is negligible next to inserting the periods
+    QBENCHMARK {
+        FreeBusyItemModel model;
+        model.addItems(items);
+        for (int i = 0; i < attendees; ++i) {
+            model.slotInsertFreeBusy(fb, email(i));
+        }
+    }
+}
+
+void FreeBusyModelBenchmark::benchmarkUpdateFreeBusy_data()
+{
+    addAttendeeRows();
+}
+
+void FreeBusyModelBenchmark::benchmarkUpdateFreeBusy()
+{
+    QFETCH(int, attendees);
+    FreeBusyItemModel model;
+    model.addItems(makeItems(attendees, PeriodCount / attendees));
+
+    // Alternate between two sets of periods, so that each iteration replaces all of them
+    const KCalendarCore::FreeBusy::Ptr freeBusy[] = {makeFreeBusy(PeriodCount / attendees, 30), makeFreeBusy(PeriodCount / attendees)};
+    int iteration = 0;
+    QBENCHMARK {
+        const KCalendarCore::FreeBusy::Ptr &fb = freeBusy[iteration++ % 2];
+        for (int i = 0; i < attendees; ++i) {
+            model.slotInsertFreeBusy(fb, email(i));
+        }
+    }
+}
+
+void FreeBusyModelBenchmark::benchmarkCalendarInsert_data()
+{
+    addAttendeeRows();
+}
+
+void FreeBusyModelBenchmark::benchmarkCalendarInsert()
+{
+    QFETCH(int, attendees);
+    const QList<FreeBusyItem::Ptr> items = makeItems(attendees, PeriodCount / attendees);
+
+    QBENCHMARK {
+        FreeBusyItemModel model;
+        FreeBusyCalendar calendar;
+        calendar.setModel(&model);
+        model.addItems(items);
+    }
+}
+
+void FreeBusyModelBenchmark::benchmarkCalendarUpdate_data()
+{
+    addAttendeeRows();
+}
+
+void FreeBusyModelBenchmark::benchmarkCalendarUpdate()
+{
+    QFETCH(int, attendees);
+    FreeBusyItemModel model;
+    FreeBusyCalendar calendar;
+    calendar.setModel(&model);
+    model.addItems(makeItems(attendees, PeriodCount / attendees));
+    QCOMPARE(calendar.calendar()->rawEvents().size(), PeriodCount);
+
+    const KCalendarCore::FreeBusy::Ptr freeBusy[] = {makeFreeBusy(PeriodCount / attendees, 30), makeFreeBusy(PeriodCount / attendees)};
+    int iteration = 0;
+    QBENCHMARK {
+        const KCalendarCore::FreeBusy::Ptr &fb = freeBusy[iteration++ % 2];
+        for (int i = 0; i < attendees; ++i) {
+            model.slotInsertFreeBusy(fb, email(i));
+        }
+    }
+    QCOMPARE(calendar.calendar()->rawEvents().size(), PeriodCount);
+}
+
+void FreeBusyModelBenchmark::benchmarkNewFreePeriods_data()
+{
+    QTest::addColumn<int>("length");
+    QTest::addColumn<bool>("overlapping");
+
+    // Free periods within a day, and ones spanning several days
+    QTest::newRow("hours") << 4 << false;
+    QTest::newRow("days") << 60 << false;
+    QTest::newRow("overlapping") << 60 << true;
+}
+
+void FreeBusyModelBenchmark::benchmarkNewFreePeriods()
+{
+    QFETCH(int, length);
+    QFETCH(bool, overlapping);
+
+    // Periods of length hours, separated by an hour unless they overlap
+    const int step = overlapping ? length / 2 : length + 1;
+    const QDateTime start(QDate(2026, 1, 5), QTime(8, 0), QTimeZone::systemTimeZone());
+    KCalendarCore::Period::List periods;
+    periods.reserve(PeriodCount);
+    for (int i = 0; i < PeriodCount; ++i) {
+        periods.append(KCalendarCore::Period(start.addSecs(qint64(i) * step * 3600), KCalendarCore::Duration(length * 3600)));
+    }
+
+    // The model splits the periods by day as rows are fetched, so fetch all of them
+    FreePeriodModel model;
+    QBENCHMARK {
+        model.slotNewFreePeriods(periods);
+        while (model.canFetchMore({})) {
+            model.fetchMore({});
+        }
+    }
+    QVERIFY(model.rowCount() >= PeriodCount);
+}
+
+#include "moc_benchfreebusymodel.cpp"
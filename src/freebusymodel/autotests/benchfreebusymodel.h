@@ -0,0 +1,33 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+namespace CalendarSupport
+{
+class FreeBusyModelBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkAddItem_data();
+    void benchmarkAddItem();
+    void benchmarkAddItems_data();
+    void benchmarkAddItems();
+    void benchmarkInsertFreeBusy_data();
+    void benchmarkInsertFreeBusy();
+    void benchmarkUpdateFreeBusy_data();
+    void benchmarkUpdateFreeBusy();
+    void benchmarkCalendarInsert_data();
+    void benchmarkCalendarInsert();
+    void benchmarkCalendarUpdate_data();
+    void benchmarkCalendarUpdate();
+    void benchmarkNewFreePeriods_data();
+    void benchmarkNewFreePeriods();
+};
+}
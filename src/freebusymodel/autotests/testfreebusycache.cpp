@@ -0,0 +1,137 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "testfreebusycache.h"
+using namespace Qt::Literals::StringLiterals;
+
+#include "../freebusycache.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace CalendarSupport;
+using namespace std::chrono_literals;
+
+QTEST_GUILESS_MAIN(FreeBusyCacheTest)
+
+static KCalendarCore::FreeBusy::Ptr createFreeBusy()
+{
+    const QDateTime dt1(QDate(2010, 7, 24), QTime(7, 0, 0), QTimeZone::utc());
+    const QDateTime dt2(QDate(2010, 7, 24), QTime(10, 0, 0), QTimeZone::utc());
+    KCalendarCore::FreeBusyPeriod tentative(dt2, KCalendarCore::Duration(60 * 60));
+    tentative.setType(KCalendarCore::FreeBusyPeriod::BusyTentative);
+
+    KCalendarCore::FreeBusy::Ptr const fb(new KCalendarCore::FreeBusy());
+    fb->addPeriod(dt1, KCalendarCore::Duration(60 * 60));
+    fb->addPeriods(KCalendarCore::FreeBusyPeriod::List{tentative});
+    return fb;
+}
+
+void FreeBusyCacheTest::testRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    FreeBusyCache cache(dir.path() + u"/freebusy"_s);
+
+    QVERIFY(!cache.lookup(u"fred@example.com"_s).freeBusy);
+
+    const KCalendarCore::FreeBusy::Ptr fb = createFreeBusy();
+    QVERIFY(cache.insert(u"fred@example.com"_s, fb));
+
+    // Emails are compared case-insensitively
+    const FreeBusyCache::Entry entry = cache.lookup(u"Fred@Example.com"_s);
+    QVERIFY(entry.freeBusy);
+    QVERIFY(!entry.stale);
+    QVERIFY(entry.retrieved.secsTo(QDateTime::currentDateTimeUtc()) < 60);
+
+    const auto expected = fb->fullBusyPeriods();
+    const auto periods = entry.freeBusy->fullBusyPeriods();
+    QCOMPARE(periods.size(), expected.size());
+    for (int i = 0; i < periods.size(); ++i) {
+        QCOMPARE(periods.at(i), expected.at(i));
+        QCOMPARE(periods.at(i).type(), expected.at(i).type());
+    }
+
+    QVERIFY(!cache.lookup(u"joe@example.com"_s).freeBusy);
+
+    cache.remove(u"fred@example.com"_s);
+    QVERIFY(!cache.lookup(u"fred@example.com"_s).freeBusy);
+
+    QVERIFY(cache.insert(u"fred@example.com"_s, fb));
+    QVERIFY(cache.insert(u"joe@example.com"_s, fb));
+    cache.clear();
+    QVERIFY(!cache.lookup(u"fred@example.com"_s).freeBusy);
+    QVERIFY(!cache.lookup(u"joe@example.com"_s).freeBusy);
+}
+
+void FreeBusyCacheTest::testTimeToLive()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    FreeBusyCache cache(dir.path());
+    QVERIFY(cache.insert(u"fred@example.com"_s, createFreeBusy()));
+
+    cache.setTimeToLive(0s);
+    QVERIFY(cache.staleWhileRevalidate());
+    FreeBusyCache::Entry entry = cache.lookup(u"fred@example.com"_s);
+    QVERIFY(entry.freeBusy);
+    QVERIFY(entry.stale);
+
+    cache.setStaleWhileRevalidate(false);
+    entry = cache.lookup(u"fred@example.com"_s);
+    QVERIFY(!entry.freeBusy);
+
+    cache.setTimeToLive(1h);
+    entry = cache.lookup(u"fred@example.com"_s);
+    QVERIFY(entry.freeBusy);
+    QVERIFY(!entry.stale);
+}
+
+void FreeBusyCacheTest::testInvalidFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    FreeBusyCache cache(dir.path());
+    QVERIFY(cache.insert(u"fred@example.com"_s, createFreeBusy()));
+
+    const QStringList files = QDir(dir.path()).entryList(QDir::Files);
+    QCOMPARE(files.size(), 1);
+
+    // A truncated file is ignored
+    QFile file(dir.filePath(files.first()));
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() - 1));
+    file.close();
+    QVERIFY(!cache.lookup(u"fred@example.com"_s).freeBusy);
+}
+
+void FreeBusyCacheTest::testPrune()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    FreeBusyCache cache(dir.path());
+    QCOMPARE(cache.maxAge(), std::chrono::seconds(30 * 24h));
+    QCOMPARE(cache.maxEntries(), 1000);
+    QVERIFY(cache.insert(u"fred@example.com"_s, createFreeBusy()));
+    QVERIFY(cache.insert(u"joe@example.com"_s, createFreeBusy()));
+    QVERIFY(cache.insert(u"jane@example.com"_s, createFreeBusy()));
+
+    // Recent data within the limits is kept
+    cache.prune();
+    QCOMPARE(QDir(dir.path()).entryList(QDir::Files).size(), 3);
+
+    cache.setMaxEntries(2);
+    cache.prune();
+    QCOMPARE(QDir(dir.path()).entryList(QDir::Files).size(), 2);
+
+    cache.setMaxAge(0s);
+    cache.prune();
+    QVERIFY(QDir(dir.path()).entryList(QDir::Files).isEmpty());
+}
+
+#include "moc_testfreebusycache.cpp"
@@ -0,0 +1,22 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+namespace CalendarSupport
+{
+class FreeBusyCacheTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testRoundTrip();
+    void testTimeToLive();
+    void testInvalidFile();
+    void testPrune();
+};
+}
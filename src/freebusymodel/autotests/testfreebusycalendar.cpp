@@ -0,0 +1,101 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "testfreebusycalendar.h"
+#include "../freebusycache.h"
+#include "../freebusycalendar.h"
+#include "../freebusyitem.h"
+#include "../freebusyitemmodel.h"
+
+#include <KCalendarCore/Attendee>
+#include <KCalendarCore/Calendar>
+
+#include <QSet>
+#include <QStandardPaths>
+#include <QTest>
+
+#include <algorithm>
+
+using namespace CalendarSupport;
+using namespace Qt::Literals::StringLiterals;
+
+QTEST_GUILESS_MAIN(FreeBusyCalendarTest)
+
+// Returns a one hour busy period starting hour hours after the first one
+static KCalendarCore::FreeBusyPeriod period(int hour)
+{
+    const QDateTime start(QDate(2026, 1, 5), QTime(8, 0), QTimeZone::UTC);
+    return KCalendarCore::FreeBusyPeriod(start.addSecs(hour * 3600), KCalendarCore::Duration(60 * 60));
+}
+
+static KCalendarCore::FreeBusy::Ptr makeFreeBusy(const QList<int> &hours)
+{
+    KCalendarCore::FreeBusyPeriod::List periods;
+    for (int const hour : hours) {
+        periods.append(period(hour));
+    }
+    return KCalendarCore::FreeBusy::Ptr(new KCalendarCore::FreeBusy(periods));
+}
+
+// Verifies that the events of calendar mirror the periods starting at hours, with unique uids
+static void verifyEvents(const FreeBusyCalendar &calendar, const QList<int> &hours)
+{
+    const KCalendarCore::Event::List events = calendar.calendar()->rawEvents();
+    QCOMPARE(events.size(), hours.size());
+
+    QSet<QString> uids;
+    QList<QDateTime> starts;
+    for (const KCalendarCore::Event::Ptr &event : events) {
+        uids.insert(event->uid());
+        starts.append(event->dtStart());
+        QCOMPARE(calendar.calendar()->event(event->uid()), event);
+    }
+    QCOMPARE(uids.size(), events.size());
+
+    std::sort(starts.begin(), starts.end());
+    for (int i = 0; i < hours.size(); ++i) {
+        QCOMPARE(starts.at(i), period(hours.at(i)).start());
+    }
+}
+
+void FreeBusyCalendarTest::initTestCase()
+{
+    // addItem() looks up the free/busy cache, which must not be the user's
+    QStandardPaths::setTestModeEnabled(true);
+    FreeBusyCache::instance()->clear();
+}
+
+void FreeBusyCalendarTest::testInsertPeriod()
+{
+    FreeBusyItemModel model;
+    FreeBusyCalendar calendar;
+    calendar.setModel(&model);
+
+    const KCalendarCore::Attendee attendee(u"Fred"_s, u"fred@example.com"_s);
+    model.addItem(FreeBusyItem::Ptr(new FreeBusyItem(attendee, nullptr)));
+
+    const KCalendarCore::FreeBusy::Ptr fb = makeFreeBusy({0, 2, 4});
+    model.slotInsertFreeBusy(fb, attendee.email());
+    verifyEvents(calendar, {0, 2, 4});
+
+    // Periods inserted between kept ones, with free/busy data of the same uid, must
+    // not take over the uids of the events after them
+    KCalendarCore::FreeBusy::Ptr const inserted = makeFreeBusy({0, 1, 2, 3, 4});
+    inserted->setUid(fb->uid());
+    model.slotInsertFreeBusy(inserted, attendee.email());
+    verifyEvents(calendar, {0, 1, 2, 3, 4});
+
+    // Removing some of them leaves the others intact
+    KCalendarCore::FreeBusy::Ptr const removed = makeFreeBusy({1, 4});
+    removed->setUid(fb->uid());
+    model.slotInsertFreeBusy(removed, attendee.email());
+    verifyEvents(calendar, {1, 4});
+
+    model.clear();
+    QVERIFY(calendar.calendar()->rawEvents().isEmpty());
+}
+
+#include "moc_testfreebusycalendar.cpp"
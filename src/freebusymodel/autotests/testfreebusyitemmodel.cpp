@@ -8,12 +8,15 @@
 #include "testfreebusyitemmodel.h"
 using namespace Qt::Literals::StringLiterals;
 
+#include "../freebusycache.h"
 #include "../freebusyitem.h"
 #include "../freebusyitemmodel.h"
 
 #include <KCalendarCore/Attendee>
 
 #include <QAbstractItemModelTester>
+#include <QSignalSpy>
+#include <QStandardPaths>
 #include <QTest>
 
 using namespace CalendarSupport;
@@ -22,6 +25,13 @@ using namespace CalendarSupport;
 // is linked into a QCoreApplication.
 QTEST_GUILESS_MAIN(FreeBusyItemModelTest)
 
+void FreeBusyItemModelTest::initTestCase()
+{
+    // addItems() looks up the free/busy cache, which must not be the user's
+    QStandardPaths::setTestModeEnabled(true);
+    FreeBusyCache::instance()->clear();
+}
+
 void FreeBusyItemModelTest::testModelValidity()
 {
     auto model = new FreeBusyItemModel(this);
@@ -206,4 +216,160 @@ void FreeBusyItemModelTest::testInsertFreeBusy()
     QCOMPARE(model->rowCount(i), 4);
 }
 
+void FreeBusyItemModelTest::testUpdateFreeBusy()
+{
+    auto model = new FreeBusyItemModel(this);
+    new QAbstractItemModelTester(model, this);
+
+    const QDateTime dt1(QDate(2010, 7, 24), QTime(7, 0, 0), QTimeZone::utc());
+    const QDateTime dt2(QDate(2010, 7, 24), QTime(10, 0, 0), QTimeZone::utc());
+    const QDateTime dt3(QDate(2010, 7, 24), QTime(12, 0, 0), QTimeZone::utc());
+    const QDateTime dt4(QDate(2010, 7, 24), QTime(14, 0, 0), QTimeZone::utc());
+    KCalendarCore::Attendee const a1(u"fred"_s, u"fred@example.com"_s);
+    KCalendarCore::FreeBusy::Ptr const fb1(new KCalendarCore::FreeBusy());
+    fb1->addPeriod(dt1, KCalendarCore::Duration(60 * 60));
+    fb1->addPeriod(dt2, KCalendarCore::Duration(60 * 60));
+    fb1->addPeriod(dt3, KCalendarCore::Duration(60 * 60));
+
+    FreeBusyItem::Ptr const item1(new FreeBusyItem(a1, nullptr));
+    item1->setFreeBusy(fb1);
+    model->addItem(item1);
+
+    QModelIndex const i = model->index(0, 0);
+    QCOMPARE(model->rowCount(i), 3);
+
+    // dt1 is dropped, dt2 is unchanged, dt3 becomes tentative and dt4 is added
+    KCalendarCore::FreeBusy::Ptr const fb2(new KCalendarCore::FreeBusy());
+    fb2->addPeriod(dt2, KCalendarCore::Duration(60 * 60));
+    KCalendarCore::FreeBusyPeriod tentative(dt3, KCalendarCore::Duration(60 * 60));
+    tentative.setType(KCalendarCore::FreeBusyPeriod::BusyTentative);
+    fb2->addPeriods(KCalendarCore::FreeBusyPeriod::List{tentative});
+    fb2->addPeriod(dt4, KCalendarCore::Duration(60 * 60));
+
+    QSignalSpy removedSpy(model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy insertedSpy(model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy changedSpy(model, &QAbstractItemModel::dataChanged);
+
+    model->slotInsertFreeBusy(fb2, u"fred@example.com"_s);
+
+    QCOMPARE(model->rowCount(i), 3);
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(removedSpy.at(0).at(1).toInt(), 0);
+    QCOMPARE(removedSpy.at(0).at(2).toInt(), 0);
+    QCOMPARE(insertedSpy.count(), 1);
+    QCOMPARE(insertedSpy.at(0).at(1).toInt(), 2);
+    QCOMPARE(insertedSpy.at(0).at(2).toInt(), 2);
+
+    // The attendee row, then the tentative period only
+    QCOMPARE(changedSpy.count(), 2);
+    QCOMPARE(changedSpy.at(1).at(0).value<QModelIndex>(), model->index(1, 0, i));
+    QCOMPARE(changedSpy.at(1).at(1).value<QModelIndex>(), model->index(1, 0, i));
+
+    const auto fb2Periods = fb2->fullBusyPeriods();
+    for (int row = 0; row < fb2Periods.size(); ++row) {
+        const auto period = model->data(model->index(row, 0, i), FreeBusyItemModel::FreeBusyPeriodRole).value<KCalendarCore::FreeBusyPeriod>();
+        QCOMPARE(period, fb2Periods.at(row));
+        QCOMPARE(period.type(), fb2Periods.at(row).type());
+    }
+}
+
+void FreeBusyItemModelTest::testAddItems()
+{
+    auto model = new FreeBusyItemModel(this);
+    new QAbstractItemModelTester(model, this);
+
+    const QDateTime dt1(QDate(2010, 7, 24), QTime(7, 0, 0), QTimeZone::utc());
+    KCalendarCore::FreeBusy::Ptr const fb1(new KCalendarCore::FreeBusy());
+    fb1->addPeriod(dt1, KCalendarCore::Duration(60 * 60));
+
+    QList<FreeBusyItem::Ptr> items;
+    for (int i = 0; i < 5; ++i) {
+        KCalendarCore::Attendee const attendee(u"attendee %1"_s.arg(i), u"attendee%1@example.com"_s.arg(i));
+        items.append(FreeBusyItem::Ptr(new FreeBusyItem(attendee, nullptr)));
+    }
+    items.at(3)->setFreeBusy(fb1);
+
+    QSignalSpy insertedSpy(model, &QAbstractItemModel::rowsInserted);
+    model->addItems(items);
+
+    QCOMPARE(model->rowCount(), 5);
+    // One insertion of the attendees, one of the periods of the fourth attendee
+    QCOMPARE(insertedSpy.count(), 2);
+    QCOMPARE(insertedSpy.at(0).at(1).toInt(), 0);
+    QCOMPARE(insertedSpy.at(0).at(2).toInt(), 4);
+    QCOMPARE(model->rowCount(model->index(3, 0)), 1);
+
+    model->removeItem(items.at(1));
+    QCOMPARE(model->rowCount(), 4);
+    QVERIFY(!model->containsAttendee(items.at(1)->attendee()));
+    for (int i : {0, 2, 3, 4}) {
+        QVERIFY(model->containsAttendee(items.at(i)->attendee()));
+    }
+
+    // The rows after the removed one are found at their new position
+    model->slotInsertFreeBusy(fb1, u"attendee4@example.com"_s);
+    QCOMPARE(model->rowCount(model->index(3, 0)), 1);
+    QCOMPARE(model->data(model->index(3, 0), FreeBusyItemModel::AttendeeRole).value<KCalendarCore::Attendee>(), items.at(4)->attendee());
+
+    model->removeAttendee(items.at(0)->attendee());
+    QCOMPARE(model->rowCount(), 3);
+    QCOMPARE(model->data(model->index(0, 0), FreeBusyItemModel::AttendeeRole).value<KCalendarCore::Attendee>(), items.at(2)->attendee());
+}
+
+void FreeBusyItemModelTest::testReplaceCachedFreeBusy()
+{
+    auto model = new FreeBusyItemModel(this);
+    new QAbstractItemModelTester(model, this);
+
+    const QString email = u"cached@example.com"_s;
+    const QDateTime dt1(QDate(2010, 7, 24), QTime(7, 0, 0), QTimeZone::utc());
+    KCalendarCore::FreeBusy::Ptr const cached(new KCalendarCore::FreeBusy());
+    cached->addPeriod(dt1, KCalendarCore::Duration(60 * 60));
+    cached->addPeriod(dt1.addDays(1), KCalendarCore::Duration(60 * 60));
+    QVERIFY(FreeBusyCache::instance()->insert(email, cached));
+
+    // The cached busy periods are shown right away
+    const KCalendarCore::Attendee attendee(u"Cached"_s, email);
+    model->addItems({FreeBusyItem::Ptr(new FreeBusyItem(attendee, nullptr))});
+    QCOMPARE(model->rowCount(), 1);
+    QCOMPARE(model->rowCount(model->index(0, 0)), 2);
+
+    // Downloaded data without busy periods removes them
+    model->slotInsertFreeBusy(KCalendarCore::FreeBusy::Ptr(new KCalendarCore::FreeBusy()), email);
+    QCOMPARE(model->rowCount(model->index(0, 0)), 0);
+
+    FreeBusyCache::instance()->remove(email);
+}
+
+void FreeBusyItemModelTest::testUnsortedFreeBusy()
+{
+    auto model = new FreeBusyItemModel(this);
+    new QAbstractItemModelTester(model, this);
+
+    // FreeBusy::sortList() leaves periods starting at the same time in any order
+    const QDateTime dt1(QDate(2010, 7, 24), QTime(7, 0, 0), QTimeZone::utc());
+    const KCalendarCore::FreeBusyPeriod longPeriod(dt1, KCalendarCore::Duration(2 * 60 * 60));
+    const KCalendarCore::FreeBusyPeriod shortPeriod(dt1, KCalendarCore::Duration(60 * 60));
+    KCalendarCore::FreeBusy::Ptr const fb(new KCalendarCore::FreeBusy());
+    fb->addPeriods(KCalendarCore::FreeBusyPeriod::List{longPeriod, shortPeriod});
+
+    FreeBusyItem::Ptr const item(new FreeBusyItem(KCalendarCore::Attendee(u"fred"_s, u"fred@example.com"_s), nullptr));
+    item->setFreeBusy(fb);
+    model->addItem(item);
+
+    // The periods are sorted by their end as well
+    QModelIndex const i = model->index(0, 0);
+    QCOMPARE(model->rowCount(i), 2);
+    QCOMPARE(model->data(model->index(0, 0, i), FreeBusyItemModel::FreeBusyPeriodRole).value<KCalendarCore::FreeBusyPeriod>(), shortPeriod);
+    QCOMPARE(model->data(model->index(1, 0, i), FreeBusyItemModel::FreeBusyPeriodRole).value<KCalendarCore::FreeBusyPeriod>(), longPeriod);
+
+    // So the same data again changes no period
+    QSignalSpy removedSpy(model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy insertedSpy(model, &QAbstractItemModel::rowsInserted);
+    model->slotInsertFreeBusy(fb, u"fred@example.com"_s);
+    QCOMPARE(model->rowCount(i), 2);
+    QCOMPARE(removedSpy.count(), 0);
+    QCOMPARE(insertedSpy.count(), 0);
+}
+
 #include "moc_testfreebusyitemmodel.cpp"
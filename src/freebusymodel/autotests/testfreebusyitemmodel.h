@@ -15,8 +15,13 @@ class FreeBusyItemModelTest : public QObject
 {
     Q_OBJECT
 private Q_SLOTS:
+    void initTestCase();
     void testModelValidity();
     void testModelValidity2();
     void testInsertFreeBusy();
+    void testUpdateFreeBusy();
+    void testAddItems();
+    void testReplaceCachedFreeBusy();
+    void testUnsortedFreeBusy();
 };
 }
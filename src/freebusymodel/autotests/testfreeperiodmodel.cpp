@@ -12,8 +12,11 @@
 #include <KCalendarCore/Period>
 
 #include <QAbstractItemModelTester>
+#include <QLocale>
 #include <QTest>
 
+#include <algorithm>
+
 using namespace CalendarSupport;
 
 // Workaround QTBUG-51789 causing a crash when QtWebEngineWidgets
@@ -72,4 +75,82 @@ void FreePeriodModelTest::testSplitByDay()
     QCOMPARE(period2.end(), endDt);
 }
 
+void FreePeriodModelTest::testSplitOverlapping()
+{
+    auto model = new FreePeriodModel(this);
+    new QAbstractItemModelTester(model, this);
+
+    // The second period starts within the first one, which spans three days
+    const QDateTime start1(QDate(2010, 7, 24), QTime(8, 0, 0), QTimeZone::utc());
+    const QDateTime end1(QDate(2010, 7, 26), QTime(8, 0, 0), QTimeZone::utc());
+    const QDateTime start2(QDate(2010, 7, 24), QTime(12, 0, 0), QTimeZone::utc());
+    const QDateTime end2(QDate(2010, 7, 24), QTime(13, 0, 0), QTimeZone::utc());
+
+    KCalendarCore::Period::List list;
+    list << KCalendarCore::Period(start2, end2) << KCalendarCore::Period(start1, end1);
+
+    const KCalendarCore::Period::List splitList = model->splitPeriodsByDay(list);
+    QCOMPARE(splitList.size(), 4);
+    QVERIFY(std::is_sorted(splitList.cbegin(), splitList.cend()));
+    QCOMPARE(splitList.at(0).start(), start1);
+    QCOMPARE(splitList.at(1), KCalendarCore::Period(start2, end2));
+    QCOMPARE(splitList.at(3).end(), end1);
+
+    model->slotNewFreePeriods(list);
+    QCOMPARE(model->rowCount(), 4);
+    QVERIFY(!model->canFetchMore(QModelIndex()));
+}
+
+void FreePeriodModelTest::testFetchMore()
+{
+    auto model = new FreePeriodModel(this);
+    new QAbstractItemModelTester(model, this);
+
+    // One period per day for 2000 days, given in reverse order
+    const int count = 2000;
+    const QDateTime start(QDate(2010, 7, 24), QTime(8, 0, 0), QTimeZone::utc());
+    KCalendarCore::Period::List list;
+    for (int i = count - 1; i >= 0; --i) {
+        list << KCalendarCore::Period(start.addDays(i), KCalendarCore::Duration(60 * 60));
+    }
+
+    model->slotNewFreePeriods(list);
+    QVERIFY(model->rowCount() > 0);
+    QVERIFY(model->rowCount() < count);
+    QVERIFY(model->canFetchMore(QModelIndex()));
+
+    while (model->canFetchMore(QModelIndex())) {
+        model->fetchMore(QModelIndex());
+    }
+    QCOMPARE(model->rowCount(), count);
+
+    for (int row = 0; row < count; ++row) {
+        const auto period = model->data(model->index(row, 0), FreePeriodModel::PeriodRole).value<KCalendarCore::Period>();
+        QCOMPARE(period.start(), start.addDays(row));
+    }
+}
+
+void FreePeriodModelTest::testLocaleChange()
+{
+    const QLocale oldLocale;
+    auto model = new FreePeriodModel(this);
+
+    const QDateTime dt(QDate(2010, 7, 24), QTime(7, 0, 0), QTimeZone::utc());
+    model->slotNewFreePeriods({KCalendarCore::Period(dt, KCalendarCore::Duration(60 * 60))});
+    QCOMPARE(model->rowCount(), 1);
+
+    // The cached strings are formatted again once the default locale changed
+    const QLocale english(QLocale::English, QLocale::UnitedStates);
+    QLocale::setDefault(english);
+    QVERIFY(model->data(model->index(0, 0)).toString().contains(english.dayName(6)));
+    QVERIFY(model->data(model->index(0, 1)).toString().contains(english.monthName(7)));
+
+    const QLocale german(QLocale::German, QLocale::Germany);
+    QLocale::setDefault(german);
+    QVERIFY(model->data(model->index(0, 0)).toString().contains(german.dayName(6)));
+    QVERIFY(model->data(model->index(0, 1)).toString().contains(german.monthName(7)));
+
+    QLocale::setDefault(oldLocale);
+}
+
 #include "moc_testfreeperiodmodel.cpp"
@@ -17,5 +17,8 @@ class FreePeriodModelTest : public QObject
 private Q_SLOTS:
     void testModelValidity();
     void testSplitByDay();
+    void testSplitOverlapping();
+    void testFetchMore();
+    void testLocaleChange();
 };
 }
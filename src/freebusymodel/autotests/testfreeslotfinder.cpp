@@ -0,0 +1,130 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "testfreeslotfinder.h"
+using namespace Qt::Literals::StringLiterals;
+
+#include "../freebusyitem.h"
+#include "../freebusyitemmodel.h"
+#include "../freeslotfinder.h"
+
+#include <KCalendarCore/Attendee>
+
+#include <QSignalSpy>
+#include <QTest>
+
+using namespace CalendarSupport;
+
+QTEST_GUILESS_MAIN(FreeSlotFinderTest)
+
+static QDateTime at(int hour, int minute = 0)
+{
+    return {QDate(2010, 7, 24), QTime(hour, minute), QTimeZone::utc()};
+}
+
+static KCalendarCore::Period period(int fromHour, int toHour)
+{
+    return {at(fromHour), at(toHour)};
+}
+
+static FreeBusyItem::Ptr createItem(const QString &name, const QList<KCalendarCore::Period> &busy)
+{
+    KCalendarCore::FreeBusy::Ptr const fb(new KCalendarCore::FreeBusy());
+    for (const KCalendarCore::Period &p : busy) {
+        fb->addPeriod(p.start(), p.end());
+    }
+    fb->sortList();
+
+    FreeBusyItem::Ptr const item(new FreeBusyItem(KCalendarCore::Attendee(name, name + u"@example.com"_s), nullptr));
+    item->setFreeBusy(fb);
+    return item;
+}
+
+static void setupModel(FreeBusyItemModel *model)
+{
+    model->addItem(createItem(u"fred"_s, {period(9, 10), period(12, 13)}));
+    model->addItem(createItem(u"joe"_s, {KCalendarCore::Period(at(9, 30), at(11))}));
+}
+
+static FreeSlotFinder *createFinder(FreeBusyItemModel *model, QObject *parent)
+{
+    auto finder = new FreeSlotFinder(parent);
+    finder->setWorkDaysOnly(false);
+    finder->setTimeZone(QTimeZone::utc());
+    finder->setModel(model);
+    return finder;
+}
+
+void FreeSlotFinderTest::testFindFreeSlots()
+{
+    auto model = new FreeBusyItemModel(this);
+    setupModel(model);
+    FreeSlotFinder *finder = createFinder(model, this);
+
+    const KCalendarCore::Duration hour(60 * 60);
+    KCalendarCore::Period::List slots = finder->findFreeSlots(at(8), at(18), hour);
+    QCOMPARE(slots, KCalendarCore::Period::List({period(8, 9), period(11, 12), period(13, 18)}));
+
+    slots = finder->findFreeSlots(at(8), at(18), KCalendarCore::Duration(2 * 60 * 60));
+    QCOMPARE(slots, KCalendarCore::Period::List({period(13, 18)}));
+
+    slots = finder->findFreeSlots(at(8), at(18), hour, 2);
+    QCOMPARE(slots, KCalendarCore::Period::List({period(8, 9), period(11, 12)}));
+
+    // The range starts while an attendee is busy
+    slots = finder->findFreeSlots(at(9, 45), at(12, 30), KCalendarCore::Duration(60));
+    QCOMPARE(slots, KCalendarCore::Period::List({period(11, 12)}));
+}
+
+void FreeSlotFinderTest::testWorkingHours()
+{
+    auto model = new FreeBusyItemModel(this);
+    setupModel(model);
+    FreeSlotFinder *finder = createFinder(model, this);
+    finder->setWorkingHours(QTime(10, 0), QTime(17, 0));
+
+    const KCalendarCore::Duration hour(60 * 60);
+    KCalendarCore::Period::List slots = finder->findFreeSlots(at(8), at(18), hour);
+    QCOMPARE(slots, KCalendarCore::Period::List({period(11, 12), period(13, 17)}));
+
+    // Free time on the next day starts with its working hours
+    const QDateTime nextDay(QDate(2010, 7, 25), QTime(12, 0), QTimeZone::utc());
+    slots = finder->findFreeSlots(at(16), nextDay, hour);
+    QCOMPARE(slots, KCalendarCore::Period::List({period(16, 17), KCalendarCore::Period(nextDay.addSecs(-2 * 60 * 60), nextDay)}));
+}
+
+void FreeSlotFinderTest::testIncrementalUpdate()
+{
+    auto model = new FreeBusyItemModel(this);
+    setupModel(model);
+    FreeSlotFinder *finder = createFinder(model, this);
+
+    QSignalSpy spy(finder, &FreeSlotFinder::freePeriodsChanged);
+    finder->setSearch(at(8), at(18), KCalendarCore::Duration(60 * 60));
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.last().at(0).value<KCalendarCore::Period::List>(),
+             KCalendarCore::Period::List({period(8, 9), period(11, 12), period(13, 18)}));
+
+    // joe's new data replaces the old one
+    KCalendarCore::FreeBusy::Ptr const fb(new KCalendarCore::FreeBusy());
+    fb->addPeriod(at(13), at(14));
+    model->slotInsertFreeBusy(fb, u"joe@example.com"_s);
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.last().at(0).value<KCalendarCore::Period::List>(),
+             KCalendarCore::Period::List({period(8, 9), period(10, 12), period(14, 18)}));
+    // Starting within the new busy period counts it as busy
+    QCOMPARE(finder->findFreeSlots(at(13, 30), at(18), KCalendarCore::Duration(60 * 60)), KCalendarCore::Period::List({period(14, 18)}));
+
+    model->removeRow(0);
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.last().at(0).value<KCalendarCore::Period::List>(), KCalendarCore::Period::List({period(8, 13), period(14, 18)}));
+
+    model->clear();
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.last().at(0).value<KCalendarCore::Period::List>(), KCalendarCore::Period::List({period(8, 18)}));
+}
+
+#include "moc_testfreeslotfinder.cpp"
@@ -0,0 +1,21 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+namespace CalendarSupport
+{
+class FreeSlotFinderTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testFindFreeSlots();
+    void testWorkingHours();
+    void testIncrementalUpdate();
+};
+}
@@ -0,0 +1,215 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "freebusycache.h"
+#include "calendarsupport_debug.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimeZone>
+#include <QtEndian>
+
+#include <algorithm>
+
+using namespace CalendarSupport;
+using namespace Qt::Literals::StringLiterals;
+using namespace std::chrono_literals;
+
+Q_GLOBAL_STATIC(FreeBusyCache, globalFreeBusyCache, QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + u"/freebusy"_s)
+
+// The file layout, all numbers little endian:
+//   header: magic, version (quint32), retrieval time in ms since epoch (qint64),
+//           number of records, reserved (quint32)
+//   records: start and end in ms since epoch (qint64), period type, reserved (qint32)
+static constexpr quint32 FileMagic = 0x43424246; // "FBBC"
+static constexpr quint32 FileVersion = 1;
+static constexpr qsizetype HeaderSize = 24;
+static constexpr qsizetype RecordSize = 24;
+// insert() prunes the cache on its first call, then after this many calls
+static constexpr int PruneInterval = 100;
+
+class CalendarSupport::FreeBusyCachePrivate
+{
+public:
+    explicit FreeBusyCachePrivate(const QString &directory)
+        : mDirectory(directory)
+    {
+    }
+
+    [[nodiscard]] QString fileName(const QString &email) const
+    {
+        const QByteArray hash = QCryptographicHash::hash(email.trimmed().toLower().toUtf8(), QCryptographicHash::Sha1);
+        return mDirectory + u'/' + QString::fromLatin1(hash.toHex()) + u".fb"_s;
+    }
+
+    const QString mDirectory;
+    std::chrono::seconds mTimeToLive = 1h;
+    bool mStaleWhileRevalidate = true;
+    std::chrono::seconds mMaxAge = 30 * 24h;
+    int mMaxEntries = 1000;
+    int mInsertsUntilPrune = 0;
+};
+
+FreeBusyCache::FreeBusyCache(const QString &directory)
+    : d(new FreeBusyCachePrivate(directory))
+{
+}
+
+FreeBusyCache::~FreeBusyCache() = default;
+
+FreeBusyCache *FreeBusyCache::instance()
+{
+    return globalFreeBusyCache;
+}
+
+QString FreeBusyCache::directory() const
+{
+    return d->mDirectory;
+}
+
+void FreeBusyCache::setTimeToLive(std::chrono::seconds ttl)
+{
+    d->mTimeToLive = ttl;
+}
+
+std::chrono::seconds FreeBusyCache::timeToLive() const
+{
+    return d->mTimeToLive;
+}
+
+void FreeBusyCache::setStaleWhileRevalidate(bool enabled)
+{
+    d->mStaleWhileRevalidate = enabled;
+}
+
+bool FreeBusyCache::staleWhileRevalidate() const
+{
+    return d->mStaleWhileRevalidate;
+}
+
+void FreeBusyCache::setMaxAge(std::chrono::seconds maxAge)
+{
+    d->mMaxAge = maxAge;
+}
+
+std::chrono::seconds FreeBusyCache::maxAge() const
+{
+    return d->mMaxAge;
+}
+
+void FreeBusyCache::setMaxEntries(int count)
+{
+    d->mMaxEntries = std::max(count, 0);
+}
+
+int FreeBusyCache::maxEntries() const
+{
+    return d->mMaxEntries;
+}
+
+FreeBusyCache::Entry FreeBusyCache::lookup(const QString &email) const
+{
+    QFile file(d->fileName(email));
+    if (!file.open(QIODevice::ReadOnly) || file.size() < HeaderSize) {
+        return {};
+    }
+    const uchar *data = file.map(0, file.size());
+    if (!data) {
+        return {};
+    }
+
+    const quint32 count = qFromLittleEndian<quint32>(data + 16);
+    if (qFromLittleEndian<quint32>(data) != FileMagic || qFromLittleEndian<quint32>(data + 4) != FileVersion
+        || file.size() < HeaderSize + qint64(count) * RecordSize) {
+        qCWarning(CALENDARSUPPORT_LOG) << "Ignoring invalid free/busy cache file" << file.fileName();
+        return {};
+    }
+
+    Entry entry;
+    entry.retrieved = QDateTime::fromMSecsSinceEpoch(qFromLittleEndian<qint64>(data + 8), QTimeZone::UTC);
+    entry.stale = entry.retrieved.addSecs(d->mTimeToLive.count()) <= QDateTime::currentDateTimeUtc();
+    if (entry.stale && !d->mStaleWhileRevalidate) {
+        return {};
+    }
+
+    KCalendarCore::FreeBusyPeriod::List periods;
+    periods.reserve(count);
+    for (const uchar *record = data + HeaderSize, *end = record + qsizetype(count) * RecordSize; record != end; record += RecordSize) {
+        KCalendarCore::FreeBusyPeriod period(QDateTime::fromMSecsSinceEpoch(qFromLittleEndian<qint64>(record), QTimeZone::UTC),
+                                             QDateTime::fromMSecsSinceEpoch(qFromLittleEndian<qint64>(record + 8), QTimeZone::UTC));
+        period.setType(static_cast<KCalendarCore::FreeBusyPeriod::FreeBusyType>(qFromLittleEndian<qint32>(record + 16)));
+        periods.append(period);
+    }
+    entry.freeBusy = KCalendarCore::FreeBusy::Ptr(new KCalendarCore::FreeBusy(periods));
+    return entry;
+}
+
+bool FreeBusyCache::insert(const QString &email, const KCalendarCore::FreeBusy::Ptr &freeBusy)
+{
+    if (!freeBusy || !QDir().mkpath(d->mDirectory)) {
+        return false;
+    }
+    if (d->mInsertsUntilPrune-- == 0) {
+        prune();
+        d->mInsertsUntilPrune = PruneInterval;
+    }
+
+    const KCalendarCore::FreeBusyPeriod::List periods = freeBusy->fullBusyPeriods();
+    QByteArray buffer(HeaderSize + periods.size() * RecordSize, Qt::Uninitialized);
+    auto data = reinterpret_cast<uchar *>(buffer.data());
+    qToLittleEndian<quint32>(FileMagic, data);
+    qToLittleEndian<quint32>(FileVersion, data + 4);
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), data + 8);
+    qToLittleEndian<quint32>(periods.size(), data + 16);
+    qToLittleEndian<quint32>(0, data + 20);
+
+    uchar *record = data + HeaderSize;
+    for (const KCalendarCore::FreeBusyPeriod &period : periods) {
+        qToLittleEndian<qint64>(period.start().toMSecsSinceEpoch(), record);
+        qToLittleEndian<qint64>(period.end().toMSecsSinceEpoch(), record + 8);
+        qToLittleEndian<qint32>(period.type(), record + 16);
+        qToLittleEndian<qint32>(0, record + 20);
+        record += RecordSize;
+    }
+
+    QSaveFile file(d->fileName(email));
+    if (!file.open(QIODevice::WriteOnly) || file.write(buffer) != buffer.size() || !file.commit()) {
+        qCWarning(CALENDARSUPPORT_LOG) << "Unable to write free/busy cache file" << file.fileName() << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void FreeBusyCache::remove(const QString &email)
+{
+    QFile::remove(d->fileName(email));
+}
+
+void FreeBusyCache::clear()
+{
+    QDir dir(d->mDirectory);
+    const QStringList files = dir.entryList({u"*.fb"_s}, QDir::Files);
+    for (const QString &file : files) {
+        dir.remove(file);
+    }
+}
+
+void FreeBusyCache::prune()
+{
+    QDir dir(d->mDirectory);
+    // Newest first
+    const QFileInfoList files = dir.entryInfoList({u"*.fb"_s}, QDir::Files, QDir::Time);
+    const QDateTime oldest = QDateTime::currentDateTimeUtc().addSecs(-d->mMaxAge.count());
+    for (qsizetype i = 0; i < files.size(); ++i) {
+        if (i >= d->mMaxEntries || files.at(i).lastModified(QTimeZone::UTC) <= oldest) {
+            dir.remove(files.at(i).fileName());
+        }
+    }
+}
@@ -0,0 +1,117 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "calendarsupport_export.h"
+
+#include <KCalendarCore/FreeBusy>
+
+#include <QDateTime>
+#include <QString>
+
+#include <chrono>
+#include <memory>
+
+namespace CalendarSupport
+{
+class FreeBusyCachePrivate;
+
+/*!
+ * \internal
+ *
+ * Local cache of the free/busy data of attendees, which survives restarts.
+ *
+ * Each attendee's busy periods are stored in a file of their own, as compact
+ * (start, end, type) records that are memory mapped when read. Summaries and
+ * locations of the periods are not cached.
+ *
+ * Cached data is fresh for the time to live. Afterwards it is stale: lookup()
+ * still returns it in stale-while-revalidate mode, so that the data can be
+ * shown while it is downloaded again, and ignores it otherwise.
+ *
+ * Files are evicted by prune(), which insert() runs every now and then: those
+ * older than the maximum age, and the oldest ones beyond the maximum number
+ * of entries.
+ */
+class CALENDARSUPPORT_EXPORT FreeBusyCache
+{
+public:
+    struct Entry {
+        KCalendarCore::FreeBusy::Ptr freeBusy; ///< null if nothing usable is cached
+        QDateTime retrieved; ///< when the cached data was downloaded
+        bool stale = false; ///< whether the data is older than the time to live
+    };
+
+    /*!
+     * Creates a cache storing its files in \a directory, which is created when needed.
+     */
+    explicit FreeBusyCache(const QString &directory);
+    ~FreeBusyCache();
+
+    /*!
+     * Returns the cache shared by the free/busy models, stored in the cache
+     * location of the application.
+     */
+    static FreeBusyCache *instance();
+
+    [[nodiscard]] QString directory() const;
+
+    /*!
+     * Sets how long cached data is fresh to \a ttl. The default is one hour.
+     */
+    void setTimeToLive(std::chrono::seconds ttl);
+    [[nodiscard]] std::chrono::seconds timeToLive() const;
+
+    /*!
+     * Sets whether lookup() returns stale data to \a enabled. The default is true.
+     */
+    void setStaleWhileRevalidate(bool enabled);
+    [[nodiscard]] bool staleWhileRevalidate() const;
+
+    /*!
+     * Sets after how long cached data is evicted to \a maxAge. The default is 30 days.
+     */
+    void setMaxAge(std::chrono::seconds maxAge);
+    [[nodiscard]] std::chrono::seconds maxAge() const;
+
+    /*!
+     * Sets how many attendees are cached at most to \a count. The default is 1000.
+     */
+    void setMaxEntries(int count);
+    [[nodiscard]] int maxEntries() const;
+
+    /*!
+     * Returns the cached free/busy data of \a email.
+     */
+    [[nodiscard]] Entry lookup(const QString &email) const;
+
+    /*!
+     * Stores \a freeBusy as the free/busy data of \a email, downloaded now.
+     * Returns false if it could not be written.
+     */
+    bool insert(const QString &email, const KCalendarCore::FreeBusy::Ptr &freeBusy);
+
+    /*!
+     * Removes the cached data of \a email.
+     */
+    void remove(const QString &email);
+
+    /*!
+     * Removes all cached data.
+     */
+    void clear();
+
+    /*!
+     * Removes the cached data older than the maximum age, and the oldest data
+     * beyond the maximum number of entries.
+     */
+    void prune();
+
+private:
+    std::unique_ptr<FreeBusyCachePrivate> const d;
+};
+}
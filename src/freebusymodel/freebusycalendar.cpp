@@ -13,20 +13,222 @@
 
 #include <KLocalizedString>
 
+#include <QHash>
 #include <QTimeZone>
 
+#include <map>
+
 using namespace CalendarSupport;
 using namespace Qt::Literals::StringLiterals;
 class CalendarSupport::FreeBusyCalendarPrivate
 {
 public:
+    // Identifies the event of a busy period of an attendee, independently of the
+    // period's row in the model
+    using PeriodKey = std::pair<qint64, qint64>;
+    using EventMap = std::multimap<PeriodKey, KCalendarCore::Event::Ptr>;
+
     FreeBusyCalendarPrivate() = default;
 
+    static PeriodKey key(const KCalendarCore::Period &period)
+    {
+        return {period.start().toMSecsSinceEpoch(), period.end().toMSecsSinceEpoch()};
+    }
+
+    // Returns the summary of periods of type without one, translated once
+    const QString &statusSummary(KCalendarCore::FreeBusyPeriod::FreeBusyType type)
+    {
+        auto it = mStatusSummaries.find(type);
+        if (it == mStatusSummaries.end()) {
+            QString summary;
+            switch (type) {
+            case KCalendarCore::FreeBusyPeriod::Free:
+                summary = i18n("Free");
+                break;
+            case KCalendarCore::FreeBusyPeriod::Busy:
+                summary = i18n("Busy");
+                break;
+            case KCalendarCore::FreeBusyPeriod::BusyUnavailable:
+                summary = i18n("Unavailable");
+                break;
+            case KCalendarCore::FreeBusyPeriod::BusyTentative:
+                summary = i18n("Tentative");
+                break;
+            default:
+                summary = i18n("Unknown");
+            }
+            it = mStatusSummaries.insert(type, summary);
+        }
+        return it.value();
+    }
+
+    [[nodiscard]] QString summary(const KCalendarCore::FreeBusyPeriod &period)
+    {
+        return period.summary().isEmpty() ? statusSummary(period.type()) : period.summary();
+    }
+
+    void setPeriod(const KCalendarCore::Event::Ptr &inc, const KCalendarCore::FreeBusyPeriod &period)
+    {
+        inc->setDtStart(period.start());
+        inc->setDtEnd(period.end());
+        inc->setCustomProperty("FREEBUSY", "STATUS", QString::number(period.type()));
+        inc->setSummary(summary(period));
+    }
+
+    // Updates the details of inc if they differ from those of period
+    void updatePeriod(const KCalendarCore::Event::Ptr &inc, const KCalendarCore::FreeBusyPeriod &period)
+    {
+        if (inc->customProperty("FREEBUSY", "STATUS") != QString::number(period.type()) || inc->summary() != summary(period)) {
+            mCalendar->beginChange(inc);
+            setPeriod(inc, period);
+            mCalendar->endChange(inc);
+        }
+    }
+
+    // Adds the event of period, with a uid starting with uidPrefix. Events are kept
+    // while rows are inserted and removed around them, so the uids are numbered in
+    // the order the events are created rather than by row.
+    void addEvent(EventMap &events, const QString &uidPrefix, const KCalendarCore::FreeBusyPeriod &period)
+    {
+        KCalendarCore::Event::Ptr const inc = KCalendarCore::Event::Ptr(new KCalendarCore::Event());
+        inc->setUid(uidPrefix + QString::number(mNextUid++));
+        setPeriod(inc, period);
+        events.emplace(key(period), inc);
+        mCalendar->addEvent(inc);
+    }
+
+    // Deletes one event of period from the events of email
+    void deleteEvent(const QString &email, const KCalendarCore::Period &period)
+    {
+        auto attendee = mFbEvents.find(email);
+        if (attendee == mFbEvents.end()) {
+            return;
+        }
+        auto it = attendee->find(key(period));
+        if (it != attendee->end()) {
+            mCalendar->deleteEvent(it->second);
+            attendee->erase(it);
+        }
+        if (attendee->empty()) {
+            mFbEvents.erase(attendee);
+        }
+    }
+
+    [[nodiscard]] QString email(const QModelIndex &parent) const
+    {
+        return mModel->data(parent, FreeBusyItemModel::AttendeeRole).value<KCalendarCore::Attendee>().email();
+    }
+
+    [[nodiscard]] QString uidPrefix(const QModelIndex &parent) const
+    {
+        const auto fb = mModel->data(parent, FreeBusyItemModel::FreeBusyRole).value<KCalendarCore::FreeBusy::Ptr>();
+        return "fb-"_L1 + (fb ? fb->uid() : QString()) + u'-';
+    }
+
+    [[nodiscard]] KCalendarCore::FreeBusyPeriod rowPeriod(const QModelIndex &parent, int row) const
+    {
+        return mModel->data(mModel->index(row, 0, parent), FreeBusyItemModel::FreeBusyPeriodRole).value<KCalendarCore::FreeBusyPeriod>();
+    }
+
+    // Returns the busy periods of the rows first to last of the attendee at parent
+    [[nodiscard]] KCalendarCore::FreeBusyPeriod::List periods(const QModelIndex &parent, int first, int last) const
+    {
+        if (last < first) {
+            return {};
+        }
+        // The rows are the periods of the attendee's free/busy data, unless the data
+        // was replaced without telling the model
+        const auto fb = mModel->data(parent, FreeBusyItemModel::FreeBusyRole).value<KCalendarCore::FreeBusy::Ptr>();
+        if (fb) {
+            const KCalendarCore::FreeBusyPeriod::List periods = fb->fullBusyPeriods();
+            if (last < periods.size() && periods.at(first) == rowPeriod(parent, first) && periods.at(last) == rowPeriod(parent, last)) {
+                return periods.mid(first, last - first + 1);
+            }
+        }
+
+        KCalendarCore::FreeBusyPeriod::List periods;
+        periods.reserve(last - first + 1);
+        for (int i = first; i <= last; ++i) {
+            periods.append(rowPeriod(parent, i));
+        }
+        return periods;
+    }
+
+    // Brings the events in line with the whole model, only touching the events of
+    // periods that were added, removed or changed
+    void synchronize();
+
     FreeBusyItemModel *mModel = nullptr;
     KCalendarCore::Calendar::Ptr mCalendar;
-    QMap<QModelIndex, KCalendarCore::Event::Ptr> mFbEvent;
+    // The events mirroring the busy periods, by attendee email
+    QHash<QString, EventMap> mFbEvents;
+    QHash<int, QString> mStatusSummaries;
+    quint64 mNextUid = 0;
 };
 
+void FreeBusyCalendarPrivate::synchronize()
+{
+    struct Wanted {
+        KCalendarCore::FreeBusyPeriod period;
+        QString uidPrefix;
+    };
+    QHash<QString, std::multimap<PeriodKey, Wanted>> wanted;
+    for (int i = 0, count = mModel->rowCount(); i < count; ++i) {
+        QModelIndex const parent = mModel->index(i, 0);
+        const KCalendarCore::FreeBusyPeriod::List periods = this->periods(parent, 0, mModel->rowCount(parent) - 1);
+        if (periods.isEmpty()) {
+            continue;
+        }
+        const QString prefix = uidPrefix(parent);
+        auto &attendee = wanted[email(parent)];
+        for (const KCalendarCore::FreeBusyPeriod &period : periods) {
+            attendee.emplace(key(period), Wanted{period, prefix});
+        }
+    }
+
+    mCalendar->startBatchAdding();
+    for (auto it = mFbEvents.begin(); it != mFbEvents.end();) {
+        const auto attendee = wanted.constFind(it.key());
+        EventMap &events = it.value();
+        if (attendee == wanted.cend()) {
+            for (const auto &[periodKey, inc] : events) {
+                mCalendar->deleteEvent(inc);
+            }
+            it = mFbEvents.erase(it);
+            continue;
+        }
+
+        // Both are sorted by period, so walk them side by side
+        EventMap kept;
+        auto event = events.begin();
+        auto period = attendee->cbegin();
+        while (event != events.end() || period != attendee->cend()) {
+            if (period == attendee->cend() || (event != events.end() && event->first < period->first)) {
+                mCalendar->deleteEvent(event->second);
+                ++event;
+            } else if (event == events.end() || period->first < event->first) {
+                addEvent(kept, period->second.uidPrefix, period->second.period);
+                ++period;
+            } else {
+                updatePeriod(event->second, period->second.period);
+                kept.emplace_hint(kept.end(), event->first, event->second);
+                ++event;
+                ++period;
+            }
+        }
+        events = std::move(kept);
+        wanted.remove(it.key());
+        ++it;
+    }
+    for (auto attendee = wanted.cbegin(); attendee != wanted.cend(); ++attendee) {
+        EventMap &events = mFbEvents[attendee.key()];
+        for (const auto &[periodKey, w] : attendee.value()) {
+            addEvent(events, w.uidPrefix, w.period);
+        }
+    }
+    mCalendar->endBatchAdding();
+}
+
 FreeBusyCalendar::FreeBusyCalendar(QObject *parent)
     : QObject(parent)
     , d(new CalendarSupport::FreeBusyCalendarPrivate)
@@ -58,74 +260,39 @@ void FreeBusyCalendar::setModel(FreeBusyItemModel *model)
         }
         d->mModel = model;
         connect(d->mModel, &QAbstractItemModel::layoutChanged, this, &FreeBusyCalendar::onLayoutChanged);
-        connect(d->mModel, &QAbstractItemModel::modelReset, this, &FreeBusyCalendar::onLayoutChanged);
+        connect(d->mModel, &QAbstractItemModel::modelReset, this, &FreeBusyCalendar::onModelReset);
         connect(d->mModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &FreeBusyCalendar::onRowsRemoved);
         connect(d->mModel, &QAbstractItemModel::rowsInserted, this, &FreeBusyCalendar::onRowsInserted);
         connect(d->mModel, &QAbstractItemModel::dataChanged, this, &FreeBusyCalendar::onRowsChanged);
     }
 }
 
-void FreeBusyCalendar::deleteAllEvents()
+void FreeBusyCalendar::onModelReset()
 {
-    const KCalendarCore::Event::List lstEvents = d->mCalendar->events();
-    for (const KCalendarCore::Event::Ptr &event : lstEvents) {
-        d->mCalendar->deleteEvent(event);
-    }
+    d->synchronize();
 }
 
 void FreeBusyCalendar::onLayoutChanged()
 {
-    if (!d->mFbEvent.isEmpty()) {
-        deleteAllEvents();
-        d->mFbEvent.clear();
-        for (int i = d->mModel->rowCount() - 1; i >= 0; --i) {
-            QModelIndex const parent = d->mModel->index(i, 0);
-            onRowsInserted(parent, 0, d->mModel->rowCount(parent) - 1);
-        }
-    }
+    d->synchronize();
 }
 
 void FreeBusyCalendar::onRowsInserted(const QModelIndex &parent, int first, int last)
 {
-    if (!parent.isValid()) {
+    if (!parent.isValid() || last < first) {
         return;
     }
-    for (int i = first; i <= last; ++i) {
-        QModelIndex const index = d->mModel->index(i, 0, parent);
-
-        const KCalendarCore::FreeBusyPeriod &period = d->mModel->data(index, FreeBusyItemModel::FreeBusyPeriodRole).value<KCalendarCore::FreeBusyPeriod>();
-        const KCalendarCore::FreeBusy::Ptr &fb = d->mModel->data(parent, FreeBusyItemModel::FreeBusyRole).value<KCalendarCore::FreeBusy::Ptr>();
-
-        KCalendarCore::Event::Ptr const inc = KCalendarCore::Event::Ptr(new KCalendarCore::Event());
-        inc->setDtStart(period.start());
-        inc->setDtEnd(period.end());
-        inc->setUid("fb-"_L1 + fb->uid() + "-"_L1 + QString::number(i));
 
-        inc->setCustomProperty("FREEBUSY", "STATUS", QString::number(period.type()));
-        QString summary = period.summary();
-        if (summary.isEmpty()) {
-            switch (period.type()) {
-            case KCalendarCore::FreeBusyPeriod::Free:
-                summary = i18n("Free");
-                break;
-            case KCalendarCore::FreeBusyPeriod::Busy:
-                summary = i18n("Busy");
-                break;
-            case KCalendarCore::FreeBusyPeriod::BusyUnavailable:
-                summary = i18n("Unavailable");
-                break;
-            case KCalendarCore::FreeBusyPeriod::BusyTentative:
-                summary = i18n("Tentative");
-                break;
-            default:
-                summary = i18n("Unknown");
-            }
-        }
-        inc->setSummary(summary);
+    // Read the periods, email and uid once, rather than going through data() for every row
+    const KCalendarCore::FreeBusyPeriod::List periods = d->periods(parent, first, last);
+    const QString uidPrefix = d->uidPrefix(parent);
+    FreeBusyCalendarPrivate::EventMap &events = d->mFbEvents[d->email(parent)];
 
-        d->mFbEvent.insert(index, inc);
-        d->mCalendar->addEvent(inc);
+    d->mCalendar->startBatchAdding();
+    for (const KCalendarCore::FreeBusyPeriod &period : periods) {
+        d->addEvent(events, uidPrefix, period);
     }
+    d->mCalendar->endBatchAdding();
 }
 
 void FreeBusyCalendar::onRowsRemoved(const QModelIndex &parent, int first, int last)
@@ -135,25 +302,33 @@ void FreeBusyCalendar::onRowsRemoved(const QModelIndex &parent, int first, int l
             QModelIndex const index = d->mModel->index(i, 0);
             onRowsRemoved(index, 0, d->mModel->rowCount(index) - 1);
         }
-    } else {
-        for (int i = first; i <= last; ++i) {
-            QModelIndex const index = d->mModel->index(i, 0, parent);
-            KCalendarCore::Event::Ptr const inc = d->mFbEvent.take(index);
-            d->mCalendar->deleteEvent(inc);
-        }
+        return;
+    }
+
+    const QString email = d->email(parent);
+    const KCalendarCore::FreeBusyPeriod::List periods = d->periods(parent, first, last);
+    for (const KCalendarCore::FreeBusyPeriod &period : periods) {
+        d->deleteEvent(email, period);
     }
 }
 
 void FreeBusyCalendar::onRowsChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
 {
-    if (!topLeft.parent().isValid()) {
+    // The model only notifies the periods whose details changed, so refresh just those
+    const QModelIndex parent = topLeft.parent();
+    if (!parent.isValid()) {
         return;
     }
-    for (int i = topLeft.row(); i <= bottomRight.row(); ++i) {
-        QModelIndex const index = d->mModel->index(i, 0, topLeft.parent());
-        KCalendarCore::Event::Ptr const inc = d->mFbEvent.value(index);
-        d->mCalendar->beginChange(inc);
-        d->mCalendar->endChange(inc);
+    auto attendee = d->mFbEvents.find(d->email(parent));
+    if (attendee == d->mFbEvents.end()) {
+        return;
+    }
+    const KCalendarCore::FreeBusyPeriod::List periods = d->periods(parent, topLeft.row(), bottomRight.row());
+    for (const KCalendarCore::FreeBusyPeriod &period : periods) {
+        auto it = attendee->find(FreeBusyCalendarPrivate::key(period));
+        if (it != attendee->end()) {
+            d->updatePeriod(it->second, period);
+        }
     }
 }
 
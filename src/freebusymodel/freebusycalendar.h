@@ -64,7 +64,7 @@ private:
     CALENDARSUPPORT_NO_EXPORT void onRowsInserted(const QModelIndex &, int, int);
     CALENDARSUPPORT_NO_EXPORT void onRowsRemoved(const QModelIndex &, int, int);
     CALENDARSUPPORT_NO_EXPORT void onLayoutChanged();
-    CALENDARSUPPORT_NO_EXPORT void deleteAllEvents();
+    CALENDARSUPPORT_NO_EXPORT void onModelReset();
 
     std::unique_ptr<FreeBusyCalendarPrivate> const d;
 };
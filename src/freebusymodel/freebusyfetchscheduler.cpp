@@ -0,0 +1,187 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "freebusyfetchscheduler.h"
+#include "freebusycache.h"
+
+#include <Akonadi/FreeBusyManager>
+
+#include <QWidget>
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+
+using namespace CalendarSupport;
+using namespace std::chrono_literals;
+
+Q_GLOBAL_STATIC(FreeBusyFetchScheduler, globalFreeBusyFetchScheduler)
+
+// Requests are collected for this long before their downloads start
+static constexpr std::chrono::milliseconds RequestDelay = 1s;
+// Retrieved free/busy data is collected for this long before it is handed out
+static constexpr std::chrono::milliseconds ResultDelay = 100ms;
+// A download that did not deliver anything by then no longer takes the place
+// of another one, as it most likely failed silently
+static constexpr std::chrono::milliseconds FetchSlotTimeout = 10s;
+// A download that did not deliver anything by then failed
+static constexpr std::chrono::milliseconds FetchTimeout = 60s;
+// The delays before downloading the data of an email again after it failed
+static constexpr std::chrono::milliseconds MinRetryDelay = 5s;
+static constexpr std::chrono::milliseconds MaxRetryDelay = 10min;
+
+FreeBusyFetchScheduler::FreeBusyFetchScheduler()
+{
+    mTimer.setSingleShot(true);
+    connect(&mTimer, &QTimer::timeout, this, &FreeBusyFetchScheduler::process);
+
+    connect(Akonadi::FreeBusyManager::self(), &Akonadi::FreeBusyManager::freeBusyRetrieved, this, &FreeBusyFetchScheduler::slotFreeBusyRetrieved);
+}
+
+FreeBusyFetchScheduler::~FreeBusyFetchScheduler() = default;
+
+FreeBusyFetchScheduler *FreeBusyFetchScheduler::instance()
+{
+    return globalFreeBusyFetchScheduler;
+}
+
+void FreeBusyFetchScheduler::request(const QString &email, bool forceDownload, QWidget *parentWidget)
+{
+    if (email.isEmpty()) {
+        return;
+    }
+
+    auto it = mRequests.find(email);
+    if (it != mRequests.end()) {
+        it->forceDownload |= forceDownload;
+        if (!it->parentWidget) {
+            it->parentWidget = parentWidget;
+        }
+        return;
+    }
+    if (!forceDownload && mRunning.contains(email)) {
+        return;
+    }
+
+    mRequests.insert(email, Request{forceDownload, parentWidget});
+    mQueue.append(email);
+    schedule(RequestDelay);
+}
+
+bool FreeBusyFetchScheduler::isPending(const QString &email) const
+{
+    return mRequests.contains(email) || mRunning.contains(email);
+}
+
+void FreeBusyFetchScheduler::setMaxConcurrentFetches(int count)
+{
+    mMaxConcurrentFetches = std::max(count, 1);
+}
+
+int FreeBusyFetchScheduler::maxConcurrentFetches() const
+{
+    return mMaxConcurrentFetches;
+}
+
+void FreeBusyFetchScheduler::slotFreeBusyRetrieved(const KCalendarCore::FreeBusy::Ptr &fb, const QString &email)
+{
+    // Getting no data is an answer too, so it does not count as a failure
+    mRunning.remove(email);
+    mBackOffs.remove(email);
+    if (fb) {
+        FreeBusyCache::instance()->insert(email, fb);
+        mResults.insert(email, fb);
+    } else {
+        Q_EMIT freeBusyUnavailable(email);
+    }
+    schedule(ResultDelay);
+}
+
+void FreeBusyFetchScheduler::schedule(std::chrono::milliseconds delay)
+{
+    if (!mTimer.isActive() || mTimer.remainingTimeAsDuration() > delay) {
+        mTimer.start(delay);
+    }
+}
+
+void FreeBusyFetchScheduler::process()
+{
+    if (!mResults.isEmpty()) {
+        const auto results = std::exchange(mResults, {});
+        Q_EMIT freeBusyRetrieved(results);
+    }
+
+    QList<QString> expired;
+    for (auto it = mRunning.cbegin(), end = mRunning.cend(); it != end; ++it) {
+        if (it->timeout.hasExpired()) {
+            expired.append(it.key());
+        }
+    }
+    for (const QString &email : std::as_const(expired)) {
+        mRunning.remove(email);
+        fetchFailed(email);
+    }
+
+    // Start the oldest requests which are not being backed off. Starting a
+    // download may queue new requests, so the queue is walked by index.
+    for (int i = 0; i < mQueue.size() && activeFetches() < mMaxConcurrentFetches;) {
+        if (!mBackOffs.value(mQueue.at(i)).retryAfter.hasExpired()) {
+            ++i;
+            continue;
+        }
+        const QString email = mQueue.takeAt(i);
+        startFetch(email, mRequests.take(email));
+    }
+
+    // Wake up again for the next timeout or the end of the next back-off
+    std::optional<std::chrono::nanoseconds> wake;
+    auto wakeAt = [&wake](const QDeadlineTimer &deadline) {
+        const auto remaining = deadline.remainingTimeAsDuration();
+        if (!wake || remaining < *wake) {
+            wake = remaining;
+        }
+    };
+    for (const Fetch &fetch : std::as_const(mRunning)) {
+        wakeAt(fetch.slot.hasExpired() ? fetch.timeout : fetch.slot);
+    }
+    if (activeFetches() < mMaxConcurrentFetches) {
+        for (const QString &email : std::as_const(mQueue)) {
+            wakeAt(mBackOffs.value(email).retryAfter);
+        }
+    }
+    if (wake) {
+        schedule(std::chrono::ceil<std::chrono::milliseconds>(*wake));
+    }
+}
+
+void FreeBusyFetchScheduler::startFetch(const QString &email, const Request &request)
+{
+    mRunning.insert(email, Fetch{QDeadlineTimer(FetchSlotTimeout), QDeadlineTimer(FetchTimeout)});
+    if (!Akonadi::FreeBusyManager::self()->retrieveFreeBusy(email, request.forceDownload, request.parentWidget)) {
+        // No free/busy source is known for this email
+        if (mRunning.remove(email)) {
+            Q_EMIT freeBusyUnavailable(email);
+        }
+    }
+}
+
+void FreeBusyFetchScheduler::fetchFailed(const QString &email)
+{
+    BackOff &backOff = mBackOffs[email];
+    ++backOff.failures;
+    const std::chrono::milliseconds delay(MinRetryDelay.count() << std::min(backOff.failures - 1, 16));
+    backOff.retryAfter = QDeadlineTimer(std::min(delay, MaxRetryDelay));
+    Q_EMIT freeBusyUnavailable(email);
+}
+
+int FreeBusyFetchScheduler::activeFetches() const
+{
+    return std::count_if(mRunning.cbegin(), mRunning.cend(), [](const Fetch &fetch) {
+        return !fetch.slot.hasExpired();
+    });
+}
+
+#include "moc_freebusyfetchscheduler.cpp"
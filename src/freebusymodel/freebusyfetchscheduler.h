@@ -0,0 +1,108 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <KCalendarCore/FreeBusy>
+
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+#include <chrono>
+
+class QWidget;
+
+namespace CalendarSupport
+{
+/*!
+ * \internal
+ *
+ * Process-wide queue of free/busy downloads, shared by all FreeBusyItemModels.
+ *
+ * Requests are collected by a single coalescing timer. A request for an email
+ * that is already queued or being downloaded is merged with it, only a limited
+ * number of downloads run at the same time, and emails whose downloads do not
+ * answer are retried with an increasing delay. The free/busy data retrieved by
+ * Akonadi::FreeBusyManager is handed out in batches by freeBusyRetrieved().
+ *
+ * Akonadi::FreeBusyManager does not tell about failed downloads, so a download
+ * that did not answer for a while gives up its place to the next one, and is
+ * considered failed after a timeout. Only that email is backed off, as others
+ * of the same domain may well have free/busy data.
+ */
+class FreeBusyFetchScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    FreeBusyFetchScheduler();
+    ~FreeBusyFetchScheduler() override;
+
+    static FreeBusyFetchScheduler *instance();
+
+    /*!
+     * Queues a download of the free/busy data of \a email.
+     * \a parentWidget is passed to Akonadi when fetching free/busy data.
+     */
+    void request(const QString &email, bool forceDownload, QWidget *parentWidget);
+
+    /*!
+     * Returns true if the free/busy data of \a email is queued or being downloaded.
+     */
+    [[nodiscard]] bool isPending(const QString &email) const;
+
+    /*!
+     * Sets the number of downloads running at the same time to \a count.
+     * The default is 4.
+     */
+    void setMaxConcurrentFetches(int count);
+    [[nodiscard]] int maxConcurrentFetches() const;
+
+Q_SIGNALS:
+    /*!
+     * Emitted with the free/busy data retrieved since the last emission, by email.
+     */
+    void freeBusyRetrieved(const QHash<QString, KCalendarCore::FreeBusy::Ptr> &freeBusy);
+
+    /*!
+     * Emitted when no free/busy data could be retrieved for \a email.
+     */
+    void freeBusyUnavailable(const QString &email);
+
+private:
+    struct Request {
+        bool forceDownload = false;
+        QPointer<QWidget> parentWidget;
+    };
+
+    struct Fetch {
+        QDeadlineTimer slot; ///< when the download stops counting as running
+        QDeadlineTimer timeout; ///< when the download failed
+    };
+
+    struct BackOff {
+        int failures = 0;
+        QDeadlineTimer retryAfter;
+    };
+
+    void slotFreeBusyRetrieved(const KCalendarCore::FreeBusy::Ptr &fb, const QString &email);
+    void schedule(std::chrono::milliseconds delay);
+    void process();
+    void startFetch(const QString &email, const Request &request);
+    void fetchFailed(const QString &email);
+    [[nodiscard]] int activeFetches() const;
+
+    QTimer mTimer;
+    QList<QString> mQueue;
+    QHash<QString, Request> mRequests;
+    QHash<QString, Fetch> mRunning;
+    QHash<QString, BackOff> mBackOffs;
+    QHash<QString, KCalendarCore::FreeBusy::Ptr> mResults;
+    int mMaxConcurrentFetches = 4;
+};
+}
@@ -8,8 +8,7 @@
 */
 
 #include "freebusyitem.h"
-
-#include <Akonadi/FreeBusyManager>
+#include "freebusyfetchscheduler.h"
 
 using namespace CalendarSupport;
 
@@ -55,10 +54,7 @@ int FreeBusyItem::updateTimerID() const
 void FreeBusyItem::startDownload(bool forceDownload)
 {
     mIsDownloading = true;
-    Akonadi::FreeBusyManager *m = Akonadi::FreeBusyManager::self();
-    if (!m->retrieveFreeBusy(attendee().email(), forceDownload, mParentWidget)) {
-        mIsDownloading = false;
-    }
+    FreeBusyFetchScheduler::instance()->request(email(), forceDownload, mParentWidget);
 }
 
 void FreeBusyItem::setIsDownloading(bool d)
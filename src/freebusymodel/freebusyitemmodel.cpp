@@ -6,14 +6,16 @@
 */
 
 #include "freebusyitemmodel.h"
+#include "freebusycache.h"
+#include "freebusyfetchscheduler.h"
 using namespace Qt::Literals::StringLiterals;
 
-#include <Akonadi/FreeBusyManager>
-
 #include <KLocalizedString>
 
+#include <QHash>
 #include <QLocale>
-#include <QTimerEvent>
+
+#include <algorithm>
 
 using namespace CalendarSupport;
 
@@ -40,6 +42,11 @@ public:
         childItems.append(item);
     }
 
+    void insertChild(int row, ItemPrivateData *item)
+    {
+        childItems.insert(row, item);
+    }
+
     ItemPrivateData *removeChild(int row)
     {
         return childItems.takeAt(row);
@@ -63,6 +70,9 @@ public:
         return parentItem;
     }
 
+    // The busy period shown by a child item
+    KCalendarCore::FreeBusyPeriod period;
+
 private:
     QList<ItemPrivateData *> childItems;
     ItemPrivateData *parentItem = nullptr;
@@ -76,10 +86,35 @@ public:
         delete mRootData;
     }
 
+    // Returns the row of the item of attendee, or -1
+    [[nodiscard]] int rowOf(const KCalendarCore::Attendee &attendee) const
+    {
+        for (auto it = mRowsByEmail.constFind(attendee.email()); it != mRowsByEmail.cend() && it.key() == attendee.email(); ++it) {
+            if (mFreeBusyItems.at(it.value())->attendee() == attendee) {
+                return it.value();
+            }
+        }
+        return -1;
+    }
+
+    // Returns the row of freebusy, or -1
+    [[nodiscard]] int rowOf(const FreeBusyItem::Ptr &freebusy) const
+    {
+        for (auto it = mRowsByEmail.constFind(freebusy->email()); it != mRowsByEmail.cend() && it.key() == freebusy->email(); ++it) {
+            if (mFreeBusyItems.at(it.value()) == freebusy) {
+                return it.value();
+            }
+        }
+        return -1;
+    }
+
     QTimer mReloadTimer;
     bool mForceDownload = false;
     QList<FreeBusyItem::Ptr> mFreeBusyItems;
     ItemPrivateData *mRootData = nullptr;
+
+    // Lookup index over mFreeBusyItems, updated whenever items are added or removed
+    QMultiHash<QString, int> mRowsByEmail;
 };
 
 FreeBusyItemModel::FreeBusyItemModel(QObject *parent)
@@ -90,8 +125,9 @@ FreeBusyItemModel::FreeBusyItemModel(QObject *parent)
     qRegisterMetaType<KCalendarCore::FreeBusy::Ptr>("KCalendarCore::FreeBusy::Ptr");
     qRegisterMetaType<KCalendarCore::Period>("KCalendarCore::Period");
 
-    Akonadi::FreeBusyManager const *m = Akonadi::FreeBusyManager::self();
-    connect(m, &Akonadi::FreeBusyManager::freeBusyRetrieved, this, &FreeBusyItemModel::slotInsertFreeBusy);
+    FreeBusyFetchScheduler const *scheduler = FreeBusyFetchScheduler::instance();
+    connect(scheduler, &FreeBusyFetchScheduler::freeBusyRetrieved, this, &FreeBusyItemModel::slotFreeBusyRetrieved);
+    connect(scheduler, &FreeBusyFetchScheduler::freeBusyUnavailable, this, &FreeBusyItemModel::slotFreeBusyUnavailable);
 
     connect(&d->mReloadTimer, &QTimer::timeout, this, &FreeBusyItemModel::autoReload);
     d->mReloadTimer.setSingleShot(true);
@@ -131,12 +167,7 @@ QVariant FreeBusyItemModel::data(const QModelIndex &index, int role) const
         }
     }
 
-    FreeBusyItem::Ptr const fbitem = d->mFreeBusyItems.at(data->parent()->row());
-    if (!fbitem->freeBusy() || index.row() >= fbitem->freeBusy()->busyPeriods().size()) {
-        return {};
-    }
-
-    KCalendarCore::FreeBusyPeriod const period = fbitem->freeBusy()->fullBusyPeriods().at(index.row());
+    const KCalendarCore::FreeBusyPeriod &period = data->period;
     switch (role) {
     case Qt::DisplayRole: // return something to make modeltest happy
         return u"%1 - %2"_s.arg(QLocale().toString(period.start().toLocalTime(), QLocale::ShortFormat),
@@ -216,58 +247,151 @@ QVariant FreeBusyItemModel::headerData(int section, Qt::Orientation orientation,
 
 void FreeBusyItemModel::addItem(const FreeBusyItem::Ptr &freebusy)
 {
-    int const row = d->mFreeBusyItems.size();
-    beginInsertRows(QModelIndex(), row, row);
-    d->mFreeBusyItems.append(freebusy);
-    auto itemData = new ItemPrivateData(d->mRootData);
-    d->mRootData->appendChild(itemData);
+    addItems({freebusy});
+}
+
+void FreeBusyItemModel::addItems(const QList<FreeBusyItem::Ptr> &items)
+{
+    if (items.isEmpty()) {
+        return;
+    }
+
+    // Show cached free/busy data right away. Only attendees without fresh data are
+    // downloaded, which replaces stale data once it arrives.
+    QList<bool> fresh(items.size(), false);
+    for (int i = 0; i < items.size(); ++i) {
+        if (!items.at(i)->freeBusy()) {
+            const FreeBusyCache::Entry cached = FreeBusyCache::instance()->lookup(items.at(i)->email());
+            if (cached.freeBusy) {
+                cached.freeBusy->sortList();
+                items.at(i)->setFreeBusy(cached.freeBusy);
+                fresh[i] = !cached.stale;
+            }
+        }
+    }
+
+    int const firstRow = d->mFreeBusyItems.size();
+    beginInsertRows(QModelIndex(), firstRow, firstRow + items.size() - 1);
+    d->mFreeBusyItems.append(items);
+    for (int row = firstRow; row < d->mFreeBusyItems.size(); ++row) {
+        d->mRowsByEmail.insert(d->mFreeBusyItems.at(row)->email(), row);
+        auto itemData = new ItemPrivateData(d->mRootData);
+        d->mRootData->appendChild(itemData);
+    }
     endInsertRows();
 
-    if (freebusy->freeBusy() && !freebusy->freeBusy()->fullBusyPeriods().isEmpty()) {
-        QModelIndex const itemParent = index(row, 0);
-        setFreeBusyPeriods(itemParent, freebusy->freeBusy()->fullBusyPeriods());
+    for (int row = firstRow; row < d->mFreeBusyItems.size(); ++row) {
+        const FreeBusyItem::Ptr freebusy = d->mFreeBusyItems.at(row);
+        if (freebusy->freeBusy() && !freebusy->freeBusy()->fullBusyPeriods().isEmpty()) {
+            QModelIndex const itemParent = index(row, 0);
+            setFreeBusyPeriods(itemParent, freebusy->freeBusy()->fullBusyPeriods());
+        }
+        if (!fresh.at(row - firstRow)) {
+            updateFreeBusyData(freebusy);
+        }
     }
-    updateFreeBusyData(freebusy);
 }
 
-void FreeBusyItemModel::setFreeBusyPeriods(const QModelIndex &parent, const KCalendarCore::FreeBusyPeriod::List &list)
+static bool sameInterval(const KCalendarCore::FreeBusyPeriod &p1, const KCalendarCore::FreeBusyPeriod &p2)
+{
+    return p1.start() == p2.start() && p1.end() == p2.end();
+}
+
+static bool sameDetails(const KCalendarCore::FreeBusyPeriod &p1, const KCalendarCore::FreeBusyPeriod &p2)
+{
+    return p1.type() == p2.type() && p1.summary() == p2.summary() && p1.location() == p2.location();
+}
+
+// The order of the children of an attendee: by start, then by end. FreeBusy::sortList()
+// only sorts by start.
+static bool sortsBefore(const KCalendarCore::FreeBusyPeriod &p1, const KCalendarCore::FreeBusyPeriod &p2)
+{
+    if (p1.start() != p2.start()) {
+        return p1.start() < p2.start();
+    }
+    return p1.end() < p2.end();
+}
+
+void FreeBusyItemModel::setFreeBusyPeriods(const QModelIndex &parent, KCalendarCore::FreeBusyPeriod::List list)
 {
     if (!parent.isValid()) {
         return;
     }
 
+    // The periods usually come sorted already, in which case list is not detached
+    if (!std::is_sorted(list.cbegin(), list.cend(), sortsBefore)) {
+        std::stable_sort(list.begin(), list.end(), sortsBefore);
+    }
+
+    // Both the current children and list are sorted, so a single merge pass finds the
+    // periods that were removed, added or changed. Unchanged periods are not notified.
     auto parentData = static_cast<ItemPrivateData *>(parent.internalPointer());
     int const fb_count = list.size();
-    int const childCount = parentData->childCount();
-    QModelIndex const first = index(0, 0, parent);
+    int row = 0;
+    int next = 0;
+    int changedFrom = -1;
+
+    auto flushChanged = [&]() {
+        if (changedFrom >= 0) {
+            Q_EMIT dataChanged(index(changedFrom, 0, parent), index(row - 1, 0, parent));
+            changedFrom = -1;
+        }
+    };
+
+    while (row < parentData->childCount() || next < fb_count) {
+        if (row < parentData->childCount() && next < fb_count) {
+            ItemPrivateData *childData = parentData->child(row);
+            const KCalendarCore::FreeBusyPeriod &period = list.at(next);
+            if (sameInterval(childData->period, period)) {
+                if (sameDetails(childData->period, period)) {
+                    flushChanged();
+                } else {
+                    childData->period = period;
+                    if (changedFrom < 0) {
+                        changedFrom = row;
+                    }
+                }
+                ++row;
+                ++next;
+                continue;
+            }
+        }
+        flushChanged();
 
-    if (childCount > 0 && fb_count < childCount) {
-        beginRemoveRows(parent, fb_count - 1 < 0 ? 0 : fb_count - 1, childCount - 1);
-        for (int i = childCount - 1; i > fb_count; --i) {
-            delete parentData->removeChild(i);
+        // Remove the children sorting before the next period of list
+        int removeEnd = row;
+        while (removeEnd < parentData->childCount() && (next >= fb_count || sortsBefore(parentData->child(removeEnd)->period, list.at(next)))) {
+            ++removeEnd;
         }
-        endRemoveRows();
-        if (fb_count > 0) {
-            Q_EMIT dataChanged(first, index(fb_count - 1, 0, parent));
+        if (removeEnd > row) {
+            beginRemoveRows(parent, row, removeEnd - 1);
+            for (int i = row; i < removeEnd; ++i) {
+                delete parentData->removeChild(row);
+            }
+            endRemoveRows();
+            continue;
         }
-    } else if (fb_count > childCount) {
-        beginInsertRows(parent, childCount, fb_count - 1);
-        for (int i = childCount; i < fb_count; ++i) {
+
+        // Otherwise insert the periods of list sorting before the current child
+        int insertEnd = next;
+        while (insertEnd < fb_count && (row >= parentData->childCount() || sortsBefore(list.at(insertEnd), parentData->child(row)->period))) {
+            ++insertEnd;
+        }
+        beginInsertRows(parent, row, row + insertEnd - next - 1);
+        for (; next < insertEnd; ++next, ++row) {
             auto childData = new ItemPrivateData(parentData);
-            parentData->appendChild(childData);
+            childData->period = list.at(next);
+            parentData->insertChild(row, childData);
         }
         endInsertRows();
-        if (childCount > 0) {
-            Q_EMIT dataChanged(first, index(childCount - 1, 0, parent));
-        }
-    } else if (fb_count == childCount && fb_count > 0) {
-        Q_EMIT dataChanged(first, index(childCount - 1, 0, parent));
     }
+    flushChanged();
 }
 
 void FreeBusyItemModel::clear()
 {
     beginResetModel();
+    d->mRowsByEmail.clear();
     d->mFreeBusyItems.clear();
     delete d->mRootData;
     d->mRootData = new ItemPrivateData(nullptr);
@@ -276,8 +400,15 @@ void FreeBusyItemModel::clear()
 
 void FreeBusyItemModel::removeRow(int row)
 {
+    const FreeBusyItem::Ptr item = d->mFreeBusyItems.at(row);
     beginRemoveRows(QModelIndex(), row, row);
     d->mFreeBusyItems.removeAt(row);
+    d->mRowsByEmail.remove(item->email(), row);
+    for (int i = row; i < d->mFreeBusyItems.size(); ++i) {
+        const QString email = d->mFreeBusyItems.at(i)->email();
+        d->mRowsByEmail.remove(email, i + 1);
+        d->mRowsByEmail.insert(email, i);
+    }
     ItemPrivateData const *itemData = d->mRootData->removeChild(row);
     delete itemData;
     endRemoveRows();
@@ -285,7 +416,7 @@ void FreeBusyItemModel::removeRow(int row)
 
 void FreeBusyItemModel::removeItem(const FreeBusyItem::Ptr &freebusy)
 {
-    int const row = d->mFreeBusyItems.indexOf(freebusy);
+    int const row = d->rowOf(freebusy);
     if (row >= 0) {
         removeRow(row);
     }
@@ -293,29 +424,15 @@ void FreeBusyItemModel::removeItem(const FreeBusyItem::Ptr &freebusy)
 
 void FreeBusyItemModel::removeAttendee(const KCalendarCore::Attendee &attendee)
 {
-    FreeBusyItem::Ptr anItem;
-    for (int i = 0; i < d->mFreeBusyItems.count(); ++i) {
-        anItem = d->mFreeBusyItems[i];
-        if (anItem->attendee() == attendee) {
-            if (anItem->updateTimerID() != 0) {
-                killTimer(anItem->updateTimerID());
-            }
-            removeRow(i);
-            break;
-        }
+    int const row = d->rowOf(attendee);
+    if (row >= 0) {
+        removeRow(row);
     }
 }
 
 bool FreeBusyItemModel::containsAttendee(const KCalendarCore::Attendee &attendee)
 {
-    FreeBusyItem::Ptr anItem;
-    for (int i = 0; i < d->mFreeBusyItems.count(); ++i) {
-        anItem = d->mFreeBusyItems[i];
-        if (anItem->attendee() == attendee) {
-            return true;
-        }
-    }
-    return false;
+    return d->rowOf(attendee) >= 0;
 }
 
 void FreeBusyItemModel::updateFreeBusyData(const FreeBusyItem::Ptr &item)
@@ -325,25 +442,22 @@ void FreeBusyItemModel::updateFreeBusyData(const FreeBusyItem::Ptr &item)
         return;
     }
 
-    if (item->updateTimerID() != 0) {
-        // An update timer is already running. Reset it
-        killTimer(item->updateTimerID());
-    }
+    // The scheduler merges this with the other pending requests and starts the
+    // download after a short delay
+    item->startDownload(d->mForceDownload);
+}
 
-    // This item does not have a download running, and no timer is set
-    // Do the download in one second
-    item->setUpdateTimerID(startTimer(1000));
+void FreeBusyItemModel::slotFreeBusyRetrieved(const QHash<QString, KCalendarCore::FreeBusy::Ptr> &freeBusy)
+{
+    for (auto it = freeBusy.cbegin(), end = freeBusy.cend(); it != end; ++it) {
+        slotInsertFreeBusy(it.value(), it.key());
+    }
 }
 
-void FreeBusyItemModel::timerEvent(QTimerEvent *event)
+void FreeBusyItemModel::slotFreeBusyUnavailable(const QString &email)
 {
-    killTimer(event->timerId());
-    for (const FreeBusyItem::Ptr &item : std::as_const(d->mFreeBusyItems)) {
-        if (item->updateTimerID() == event->timerId()) {
-            item->setUpdateTimerID(0);
-            item->startDownload(d->mForceDownload);
-            return;
-        }
+    for (auto it = d->mRowsByEmail.constFind(email); it != d->mRowsByEmail.cend() && it.key() == email; ++it) {
+        d->mFreeBusyItems.at(it.value())->setIsDownloading(false);
     }
 }
 
@@ -353,20 +467,16 @@ void FreeBusyItemModel::slotInsertFreeBusy(const KCalendarCore::FreeBusy::Ptr &f
         return;
     }
 
-    if (fb->fullBusyPeriods().isEmpty()) {
-        return;
-    }
-
+    // Free/busy data without busy periods is applied as well, as it replaces
+    // the busy periods shown from the cache
     fb->sortList();
 
-    for (const FreeBusyItem::Ptr &item : std::as_const(d->mFreeBusyItems)) {
-        if (item->email() == email) {
-            item->setFreeBusy(fb);
-            const int row = d->mFreeBusyItems.indexOf(item);
-            const QModelIndex itemParent = index(row, 0);
-            Q_EMIT dataChanged(itemParent, itemParent);
-            setFreeBusyPeriods(itemParent, fb->fullBusyPeriods());
-        }
+    const QList<int> rows = d->mRowsByEmail.values(email);
+    for (int const row : rows) {
+        d->mFreeBusyItems.at(row)->setFreeBusy(fb);
+        const QModelIndex itemParent = index(row, 0);
+        Q_EMIT dataChanged(itemParent, itemParent);
+        setFreeBusyPeriods(itemParent, fb->fullBusyPeriods());
     }
 }
 
@@ -12,6 +12,7 @@
 #include "freebusyitem.h"
 
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QTimer>
 
 #include <memory>
@@ -71,6 +72,13 @@ public:
      */
     void addItem(const FreeBusyItem::Ptr &freebusy);
 
+    /*!
+     * Appends \a items with a single row insertion, which is much cheaper than
+     * adding many attendees one by one.
+     * \since 6.9.0
+     */
+    void addItems(const QList<FreeBusyItem::Ptr> &items);
+
     /*!
      */
     void clear();
@@ -110,17 +118,14 @@ public Q_SLOTS:
      */
     void slotInsertFreeBusy(const KCalendarCore::FreeBusy::Ptr &fb, const QString &email);
 
-protected:
-    /*!
-     */
-    void timerEvent(QTimerEvent *) override;
-
 private:
     // Only download FB if the auto-download option is set in config
     CALENDARSUPPORT_NO_EXPORT void autoReload();
 
-    CALENDARSUPPORT_NO_EXPORT void setFreeBusyPeriods(const QModelIndex &parent, const KCalendarCore::FreeBusyPeriod::List &list);
+    CALENDARSUPPORT_NO_EXPORT void setFreeBusyPeriods(const QModelIndex &parent, KCalendarCore::FreeBusyPeriod::List list);
     CALENDARSUPPORT_NO_EXPORT void updateFreeBusyData(const FreeBusyItem::Ptr &);
+    CALENDARSUPPORT_NO_EXPORT void slotFreeBusyRetrieved(const QHash<QString, KCalendarCore::FreeBusy::Ptr> &freeBusy);
+    CALENDARSUPPORT_NO_EXPORT void slotFreeBusyUnavailable(const QString &email);
 
     std::unique_ptr<FreeBusyItemModelPrivate> const d;
 };
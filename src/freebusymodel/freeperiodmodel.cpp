@@ -15,10 +15,200 @@ using namespace Qt::Literals::StringLiterals;
 #include <QLocale>
 #include <QTimeZone>
 
+#include <algorithm>
+#include <limits>
+
 using namespace CalendarSupport;
 
+// Split fragments shorter than this are dropped
+static constexpr int ValidPeriodSecs = 300; // 5 minutes
+// The number of rows created at once
+static constexpr qsizetype FetchSize = 256;
+static constexpr qint64 MSecsPerDay = 24 * 60 * 60 * 1000;
+
+namespace
+{
+// Computes the last millisecond of the day of a time, in the time zone of that time.
+// The UTC offset is cached until the next transition of the time zone, so that most
+// days need no time zone lookup.
+class DayEnds
+{
+public:
+    QDateTime endOfDay(const QDateTime &dt)
+    {
+        const qint64 ms = dt.toMSecsSinceEpoch();
+        if (ms < mValidFrom || ms >= mValidUntil || dt.timeZone() != mTimeZone) {
+            update(dt);
+        }
+        if (mValid) {
+            const qint64 local = ms + mOffset;
+            const qint64 end = local - (((local % MSecsPerDay) + MSecsPerDay) % MSecsPerDay) + MSecsPerDay - 1 - mOffset;
+            if (end < mValidUntil) {
+                return QDateTime::fromMSecsSinceEpoch(end, mTimeZone);
+            }
+        }
+        return {dt.date(), QTime(23, 59, 59, 999), dt.timeZone()};
+    }
+
+private:
+    void update(const QDateTime &dt)
+    {
+        mTimeZone = dt.timeZone();
+        mOffset = dt.offsetFromUtc() * qint64(1000);
+        mValidFrom = dt.toMSecsSinceEpoch();
+        mValidUntil = std::numeric_limits<qint64>::max();
+        mValid = true;
+        if (mTimeZone.timeSpec() == Qt::UTC || mTimeZone.timeSpec() == Qt::OffsetFromUTC) {
+            return;
+        }
+        const QTimeZone zone = mTimeZone.timeSpec() == Qt::LocalTime ? QTimeZone::systemTimeZone() : mTimeZone;
+        if (!zone.hasTransitions()) {
+            mValid = false;
+            return;
+        }
+        const QTimeZone::OffsetData next = zone.nextTransition(dt);
+        if (next.atUtc.isValid()) {
+            mValidUntil = next.atUtc.toMSecsSinceEpoch();
+        }
+    }
+
+    QTimeZone mTimeZone;
+    qint64 mOffset = 0;
+    qint64 mValidFrom = 0;
+    qint64 mValidUntil = 0;
+    bool mValid = false;
+};
+
+// Splits periods into fragments which do not span several days, as many at a time
+// as asked for. Sorted, non-overlapping periods give sorted fragments.
+class DaySplitter
+{
+public:
+    void reset(KCalendarCore::Period::List periods)
+    {
+        mPeriods = std::move(periods);
+        mNext = 0;
+        mHasRest = false;
+        mHasLast = false;
+    }
+
+    [[nodiscard]] bool atEnd() const
+    {
+        return !mHasRest && mNext >= mPeriods.size();
+    }
+
+    // Appends up to count fragments to list
+    void split(KCalendarCore::Period::List &list, qsizetype count)
+    {
+        const qsizetype first = list.size();
+        while (list.size() - first < count) {
+            if (!mHasRest) {
+                if (mNext >= mPeriods.size()) {
+                    return;
+                }
+                const KCalendarCore::Period &period = mPeriods.at(mNext++);
+                if (period.start().date() == period.end().date()) {
+                    append(list, period); // period occurs on the same day
+                    continue;
+                }
+                if (period.end() < period.start()) {
+                    continue;
+                }
+                mRest = period;
+                mHasRest = true;
+            }
+
+            if (mRest.start().date() == mRest.end().date()) {
+                if (mRest.duration().asSeconds() >= ValidPeriodSecs) {
+                    append(list, mRest);
+                }
+                mHasRest = false;
+                continue;
+            }
+
+            const QDateTime midnight = mDayEnds.endOfDay(mRest.start());
+            const KCalendarCore::Period firstPeriod(mRest.start(), midnight);
+            if (firstPeriod.duration().asSeconds() >= ValidPeriodSecs) {
+                append(list, firstPeriod);
+            }
+            mRest = KCalendarCore::Period(midnight.addMSecs(1), mRest.end());
+        }
+    }
+
+private:
+    void append(KCalendarCore::Period::List &list, const KCalendarCore::Period &period)
+    {
+        if (!mHasLast || !(mLast == period)) {
+            list.append(period);
+            mLast = period;
+            mHasLast = true;
+        }
+    }
+
+    KCalendarCore::Period::List mPeriods;
+    qsizetype mNext = 0;
+    KCalendarCore::Period mRest; // the part of a period that is still to be split
+    bool mHasRest = false;
+    KCalendarCore::Period mLast;
+    bool mHasLast = false;
+    DayEnds mDayEnds;
+};
+}
+
+// Sorts periods, and returns whether they overlap, in which case their fragments
+// are not in order
+static bool sortPeriods(KCalendarCore::Period::List &periods)
+{
+    if (!std::is_sorted(periods.cbegin(), periods.cend())) {
+        std::sort(periods.begin(), periods.end());
+    }
+    for (qsizetype i = 1; i < periods.size(); ++i) {
+        if (periods.at(i).start() < periods.at(i - 1).end()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void sortFragments(KCalendarCore::Period::List &list)
+{
+    std::sort(list.begin(), list.end());
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+}
+
+class CalendarSupport::FreePeriodModelPrivate
+{
+public:
+    // The display strings of a row, formatted on first use. Null strings are not
+    // formatted yet.
+    struct RowStrings {
+        QString day;
+        QString date;
+        QString toolTip;
+    };
+
+    RowStrings &strings(int row)
+    {
+        // Formatting depends on the locale, so start over when it changed
+        if (const QLocale locale; locale != mLocale) {
+            mLocale = locale;
+            mStrings.clear();
+        }
+        if (row >= mStrings.size()) {
+            mStrings.resize(mPeriodList.size());
+        }
+        return mStrings[row];
+    }
+
+    KCalendarCore::Period::List mPeriodList;
+    DaySplitter mSplitter;
+    QList<RowStrings> mStrings;
+    QLocale mLocale;
+};
+
 FreePeriodModel::FreePeriodModel(QObject *parent)
     : QAbstractTableModel(parent)
+    , d(new FreePeriodModelPrivate)
 {
 }
 
@@ -30,14 +220,21 @@ QVariant FreePeriodModel::data(const QModelIndex &index, int role) const
         return {};
     }
 
+    auto cached = [this](QString &string, int row, QString (FreePeriodModel::*format)(int) const) {
+        if (string.isNull()) {
+            string = (this->*format)(row);
+        }
+        return string;
+    };
+
     if (index.column() == 0) { // day
         switch (role) {
         case Qt::DisplayRole:
-            return day(index.row());
+            return cached(d->strings(index.row()).day, index.row(), &FreePeriodModel::day);
         case Qt::ToolTipRole:
-            return tooltipify(index.row());
+            return cached(d->strings(index.row()).toolTip, index.row(), &FreePeriodModel::tooltipify);
         case FreePeriodModel::PeriodRole:
-            return QVariant::fromValue(mPeriodList.at(index.row()));
+            return QVariant::fromValue(d->mPeriodList.at(index.row()));
         case Qt::TextAlignmentRole:
             return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
         default:
@@ -46,11 +243,11 @@ QVariant FreePeriodModel::data(const QModelIndex &index, int role) const
     } else { // everything else
         switch (role) {
         case Qt::DisplayRole:
-            return date(index.row());
+            return cached(d->strings(index.row()).date, index.row(), &FreePeriodModel::date);
         case Qt::ToolTipRole:
-            return tooltipify(index.row());
+            return cached(d->strings(index.row()).toolTip, index.row(), &FreePeriodModel::tooltipify);
         case FreePeriodModel::PeriodRole:
-            return QVariant::fromValue(mPeriodList.at(index.row()));
+            return QVariant::fromValue(d->mPeriodList.at(index.row()));
         case Qt::TextAlignmentRole:
             return static_cast<int>(Qt::AlignLeft | Qt::AlignVCenter);
         default:
@@ -62,7 +259,7 @@ QVariant FreePeriodModel::data(const QModelIndex &index, int role) const
 int FreePeriodModel::rowCount(const QModelIndex &parent) const
 {
     if (!parent.isValid()) {
-        return mPeriodList.size();
+        return d->mPeriodList.size();
     }
     return 0;
 }
@@ -78,63 +275,88 @@ QVariant FreePeriodModel::headerData(int section, Qt::Orientation orientation, i
     return QAbstractItemModel::headerData(section, orientation, role);
 }
 
+bool FreePeriodModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !d->mSplitter.atEnd();
+}
+
+void FreePeriodModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid()) {
+        return;
+    }
+
+    KCalendarCore::Period::List fragments;
+    fragments.reserve(FetchSize);
+    d->mSplitter.split(fragments, FetchSize);
+    if (fragments.isEmpty()) {
+        return;
+    }
+
+    const int first = d->mPeriodList.size();
+    beginInsertRows(QModelIndex(), first, first + fragments.size() - 1);
+    d->mPeriodList.append(fragments);
+    endInsertRows();
+}
+
 void FreePeriodModel::slotNewFreePeriods(const KCalendarCore::Period::List &freePeriods)
 {
     beginResetModel();
-    mPeriodList.clear();
-    mPeriodList = splitPeriodsByDay(freePeriods);
-    std::sort(mPeriodList.begin(), mPeriodList.end());
+    d->mPeriodList.clear();
+    d->mStrings.clear();
+    KCalendarCore::Period::List periods = freePeriods;
+    const bool overlapping = sortPeriods(periods);
+    d->mSplitter.reset(std::move(periods));
+    if (overlapping) {
+        // Fragments of overlapping periods need sorting, so split them all at once
+        d->mSplitter.split(d->mPeriodList, std::numeric_limits<qsizetype>::max());
+        sortFragments(d->mPeriodList);
+    } else {
+        d->mPeriodList.reserve(FetchSize);
+        d->mSplitter.split(d->mPeriodList, FetchSize);
+    }
     endResetModel();
 }
 
 KCalendarCore::Period::List FreePeriodModel::splitPeriodsByDay(const KCalendarCore::Period::List &freePeriods)
 {
-    KCalendarCore::Period::List splitList;
-    for (const KCalendarCore::Period &period : freePeriods) {
-        if (period.start().date() == period.end().date()) {
-            splitList << period; // period occurs on the same day
-            continue;
-        }
+    KCalendarCore::Period::List periods = freePeriods;
+    const bool overlapping = sortPeriods(periods);
 
-        const int validPeriodSecs = 300; // 5 minutes
-        KCalendarCore::Period tmpPeriod = period;
-        while (tmpPeriod.start().date() != tmpPeriod.end().date()) {
-            const QDateTime midnight(tmpPeriod.start().date(), QTime(23, 59, 59, 999), tmpPeriod.start().timeZone());
-            KCalendarCore::Period const firstPeriod(tmpPeriod.start(), midnight);
-            KCalendarCore::Period const secondPeriod(midnight.addMSecs(1), tmpPeriod.end());
-            if (firstPeriod.duration().asSeconds() >= validPeriodSecs) {
-                splitList << firstPeriod;
-            }
-            tmpPeriod = secondPeriod;
-        }
-        if (tmpPeriod.duration().asSeconds() >= validPeriodSecs) {
-            splitList << tmpPeriod;
-        }
+    // Usually one fragment per day of each period
+    qsizetype fragmentCount = 0;
+    for (const KCalendarCore::Period &period : std::as_const(periods)) {
+        fragmentCount += std::max<qint64>(period.start().date().daysTo(period.end().date()), 0) + 1;
     }
 
-    // Perform some jiggery pokery to remove duplicates
-    std::sort(splitList.begin(), splitList.end());
-    splitList.erase(std::unique(splitList.begin(), splitList.end()), splitList.end());
+    DaySplitter splitter;
+    splitter.reset(std::move(periods));
+    KCalendarCore::Period::List splitList;
+    splitList.reserve(fragmentCount);
+    splitter.split(splitList, std::numeric_limits<qsizetype>::max());
+    if (overlapping) {
+        sortFragments(splitList);
+    }
     return splitList;
 }
 
 QString FreePeriodModel::day(int index) const
 {
-    KCalendarCore::Period const period = mPeriodList.at(index);
+    KCalendarCore::Period const period = d->mPeriodList.at(index);
     const QDate startDate = period.start().date();
     return ki18nc("@label Day of the week name, example: Monday,", "%1,")
-        .subs(QLocale::system().dayName(startDate.dayOfWeek(), QLocale::LongFormat))
+        .subs(QLocale().dayName(startDate.dayOfWeek(), QLocale::LongFormat))
         .toString();
 }
 
 QString FreePeriodModel::date(int index) const
 {
-    KCalendarCore::Period const period = mPeriodList.at(index);
+    KCalendarCore::Period const period = d->mPeriodList.at(index);
 
     const QDate startDate = period.start().date();
-    const QString startTime = QLocale::system().toString(period.start().time(), QLocale::ShortFormat);
-    const QString endTime = QLocale::system().toString(period.end().time(), QLocale::ShortFormat);
-    const QString longMonthName = QLocale::system().monthName(startDate.month());
+    const QString startTime = QLocale().toString(period.start().time(), QLocale::ShortFormat);
+    const QString endTime = QLocale().toString(period.end().time(), QLocale::ShortFormat);
+    const QString longMonthName = QLocale().monthName(startDate.month());
     return ki18nc(
                "@label A time period duration. It is preceded/followed (based on the "
                "orientation) by the name of the week, see the message above. "
@@ -149,13 +371,13 @@ QString FreePeriodModel::date(int index) const
 
 QString FreePeriodModel::stringify(int index) const
 {
-    KCalendarCore::Period const period = mPeriodList.at(index);
+    KCalendarCore::Period const period = d->mPeriodList.at(index);
 
     const QDate startDate = period.start().date();
     const QString startTime = QLocale().toString(period.start().time(), QLocale::ShortFormat);
     const QString endTime = QLocale().toString(period.end().time(), QLocale::ShortFormat);
-    const QString longMonthName = QLocale::system().monthName(startDate.month(), QLocale::LongFormat);
-    const QString dayofWeek = QLocale::system().dayName(startDate.dayOfWeek(), QLocale::LongFormat);
+    const QString longMonthName = QLocale().monthName(startDate.month(), QLocale::LongFormat);
+    const QString dayofWeek = QLocale().dayName(startDate.dayOfWeek(), QLocale::LongFormat);
 
     return ki18nc(
                "@label A time period duration. KLocale is used to format the components. "
@@ -171,7 +393,7 @@ QString FreePeriodModel::stringify(int index) const
 
 QString FreePeriodModel::tooltipify(int index) const
 {
-    KCalendarCore::Period const period = mPeriodList.at(index);
+    KCalendarCore::Period const period = d->mPeriodList.at(index);
     unsigned long const duration = period.duration().asSeconds() * 1000; // we want milliseconds
     QString toolTip = u"<qt>"_s;
     toolTip += QLatin1StringView("<b>") + i18nc("@info:tooltip", "Free Period") + QLatin1StringView("</b>");
@@ -13,14 +13,21 @@
 
 #include <QAbstractTableModel>
 
+#include <memory>
+
 namespace CalendarSupport
 {
+class FreePeriodModelPrivate;
+
 /*!
  * \class CalendarSupport::FreePeriodModel
  * \inmodule CalendarSupport
  * \inheaderfile CalendarSupport/FreePeriodModel
  *
  * Model representing the free-busy periods
+ *
+ * The free periods are split by day. Rows are created in chunks as views ask
+ * for them through fetchMore().
  */
 class CALENDARSUPPORT_EXPORT FreePeriodModel : public QAbstractTableModel
 {
@@ -50,6 +57,12 @@ public:
     /*!
      */
     [[nodiscard]] QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    /*!
+     */
+    [[nodiscard]] bool canFetchMore(const QModelIndex &parent) const override;
+    /*!
+     */
+    void fetchMore(const QModelIndex &parent) override;
 
 public Q_SLOTS:
     /*!
@@ -65,7 +78,7 @@ private:
     [[nodiscard]] CALENDARSUPPORT_NO_EXPORT QString stringify(int index) const;
     [[nodiscard]] CALENDARSUPPORT_NO_EXPORT QString tooltipify(int index) const;
 
-    KCalendarCore::Period::List mPeriodList;
+    std::unique_ptr<FreePeriodModelPrivate> const d;
     friend class FreePeriodModelTest;
 };
 }
@@ -0,0 +1,387 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "freeslotfinder.h"
+#include "freebusyitemmodel.h"
+#include "utils.h"
+
+#include <KCalendarCore/FreeBusyPeriod>
+
+#include <QHash>
+#include <QPointer>
+#include <QTimer>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+using namespace CalendarSupport;
+
+namespace
+{
+// A period of an attendee, in ms since epoch
+struct Interval {
+    qint64 start = 0;
+    qint64 end = 0;
+    bool busy = false;
+};
+
+// Collects free windows, merging adjacent ones, and keeps those long enough
+class SlotCollector
+{
+public:
+    SlotCollector(qint64 minLength, int count, const QTimeZone &timeZone)
+        : mMinLength(minLength)
+        , mCount(count)
+        , mTimeZone(timeZone)
+    {
+    }
+
+    void add(qint64 start, qint64 end)
+    {
+        if (end <= start) {
+            return;
+        }
+        if (mPending && start == mPendingEnd) {
+            mPendingEnd = end;
+            return;
+        }
+        flush();
+        mPending = true;
+        mPendingStart = start;
+        mPendingEnd = end;
+    }
+
+    void flush()
+    {
+        if (mPending && mPendingEnd - mPendingStart >= mMinLength && !isFull()) {
+            mSlots.append(KCalendarCore::Period(QDateTime::fromMSecsSinceEpoch(mPendingStart, mTimeZone),
+                                                QDateTime::fromMSecsSinceEpoch(mPendingEnd, mTimeZone)));
+        }
+        mPending = false;
+    }
+
+    [[nodiscard]] bool isFull() const
+    {
+        return mCount >= 0 && mSlots.size() >= mCount;
+    }
+
+    [[nodiscard]] KCalendarCore::Period::List slots()
+    {
+        flush();
+        return mSlots;
+    }
+
+private:
+    const qint64 mMinLength;
+    const int mCount;
+    const QTimeZone mTimeZone;
+    KCalendarCore::Period::List mSlots;
+    qint64 mPendingStart = 0;
+    qint64 mPendingEnd = 0;
+    bool mPending = false;
+};
+}
+
+class CalendarSupport::FreeSlotFinderPrivate
+{
+public:
+    explicit FreeSlotFinderPrivate(FreeSlotFinder *qq)
+        : q(qq)
+    {
+        mUpdateTimer.setSingleShot(true);
+        QObject::connect(&mUpdateTimer, &QTimer::timeout, q, [this]() {
+            Q_EMIT q->freePeriodsChanged(q->findFreeSlots(mSearchFrom, mSearchTo, mSearchDuration, mSearchCount));
+        });
+    }
+
+    [[nodiscard]] Interval intervalAt(const QModelIndex &index) const
+    {
+        const auto period = mModel->data(index, FreeBusyItemModel::FreeBusyPeriodRole).value<KCalendarCore::FreeBusyPeriod>();
+        return {period.start().toMSecsSinceEpoch(), period.end().toMSecsSinceEpoch(), period.type() != KCalendarCore::FreeBusyPeriod::Free};
+    }
+
+    void addBoundary(qint64 time, int delta)
+    {
+        auto it = mBoundaries.try_emplace(time, 0).first;
+        it->second += delta;
+        if (it->second == 0) {
+            mBoundaries.erase(it);
+        }
+        mBusyCounts.clear();
+    }
+
+    // Returns the number of busy attendees from each boundary on, building it from
+    // the boundaries after they changed
+    [[nodiscard]] const QList<std::pair<qint64, int>> &busyCounts() const
+    {
+        if (mBusyCounts.isEmpty() && !mBoundaries.empty()) {
+            mBusyCounts.reserve(mBoundaries.size());
+            int busy = 0;
+            for (const auto &[time, delta] : mBoundaries) {
+                busy += delta;
+                mBusyCounts.append({time, busy});
+            }
+        }
+        return mBusyCounts;
+    }
+
+    void addInterval(const Interval &interval, int sign)
+    {
+        if (interval.busy && interval.start < interval.end) {
+            addBoundary(interval.start, sign);
+            addBoundary(interval.end, -sign);
+        }
+    }
+
+    void rowsInserted(const QModelIndex &parent, int first, int last)
+    {
+        if (!parent.isValid()) {
+            return;
+        }
+        QList<Interval> &intervals = mAttendees[parent.internalId()];
+        for (int i = first; i <= last; ++i) {
+            const Interval interval = intervalAt(mModel->index(i, 0, parent));
+            intervals.insert(i, interval);
+            addInterval(interval, 1);
+        }
+        scheduleUpdate();
+    }
+
+    void rowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+    {
+        if (!parent.isValid()) {
+            for (int i = first; i <= last; ++i) {
+                const QList<Interval> intervals = mAttendees.take(mModel->index(i, 0).internalId());
+                for (const Interval &interval : intervals) {
+                    addInterval(interval, -1);
+                }
+            }
+        } else {
+            auto it = mAttendees.find(parent.internalId());
+            if (it == mAttendees.end()) {
+                return;
+            }
+            last = std::min(last, static_cast<int>(it->size()) - 1);
+            for (int i = first; i <= last; ++i) {
+                addInterval(it->at(i), -1);
+            }
+            if (first <= last) {
+                it->remove(first, last - first + 1);
+            }
+        }
+        scheduleUpdate();
+    }
+
+    void dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+    {
+        const QModelIndex parent = topLeft.parent();
+        if (!parent.isValid()) {
+            return;
+        }
+        auto it = mAttendees.find(parent.internalId());
+        if (it == mAttendees.end()) {
+            return;
+        }
+        for (int i = topLeft.row(); i <= bottomRight.row() && i < it->size(); ++i) {
+            addInterval(it->at(i), -1);
+            (*it)[i] = intervalAt(mModel->index(i, 0, parent));
+            addInterval(it->at(i), 1);
+        }
+        scheduleUpdate();
+    }
+
+    void rebuild()
+    {
+        mBoundaries.clear();
+        mBusyCounts.clear();
+        mAttendees.clear();
+        if (mModel) {
+            for (int i = 0, count = mModel->rowCount(); i < count; ++i) {
+                const QModelIndex parent = mModel->index(i, 0);
+                rowsInserted(parent, 0, mModel->rowCount(parent) - 1);
+            }
+        }
+        scheduleUpdate();
+    }
+
+    void scheduleUpdate()
+    {
+        if (mSearchFrom.isValid() && mSearchTo.isValid()) {
+            mUpdateTimer.start(0);
+        }
+    }
+
+    FreeSlotFinder *const q;
+    QPointer<FreeBusyItemModel> mModel;
+
+    // The busy periods of each attendee, in row order, keyed by the internal id of the
+    // attendee's index
+    QHash<quintptr, QList<Interval>> mAttendees;
+    // How the number of busy attendees changes at each point in time. Only non-zero
+    // changes are kept.
+    std::map<qint64, int> mBoundaries;
+    // The running sum of mBoundaries, so that the number of busy attendees at any
+    // point in time is a binary search away. Empty until needed after a change.
+    mutable QList<std::pair<qint64, int>> mBusyCounts;
+
+    QTime mWorkingHoursStart;
+    QTime mWorkingHoursEnd;
+    bool mWorkDaysOnly = true;
+    QTimeZone mTimeZone = QTimeZone::systemTimeZone();
+
+    QTimer mUpdateTimer;
+    QDateTime mSearchFrom;
+    QDateTime mSearchTo;
+    KCalendarCore::Duration mSearchDuration;
+    int mSearchCount = -1;
+};
+
+FreeSlotFinder::FreeSlotFinder(QObject *parent)
+    : QObject(parent)
+    , d(new FreeSlotFinderPrivate(this))
+{
+}
+
+FreeSlotFinder::~FreeSlotFinder() = default;
+
+void FreeSlotFinder::setModel(FreeBusyItemModel *model)
+{
+    if (model == d->mModel) {
+        return;
+    }
+    if (d->mModel) {
+        disconnect(d->mModel, nullptr, this, nullptr);
+    }
+    d->mModel = model;
+    if (model) {
+        connect(model, &QAbstractItemModel::rowsInserted, this, [this](const QModelIndex &parent, int first, int last) {
+            d->rowsInserted(parent, first, last);
+        });
+        connect(model, &QAbstractItemModel::rowsAboutToBeRemoved, this, [this](const QModelIndex &parent, int first, int last) {
+            d->rowsAboutToBeRemoved(parent, first, last);
+        });
+        connect(model, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+            d->dataChanged(topLeft, bottomRight);
+        });
+        connect(model, &QAbstractItemModel::modelReset, this, [this]() {
+            d->rebuild();
+        });
+        connect(model, &QAbstractItemModel::layoutChanged, this, [this]() {
+            d->rebuild();
+        });
+    }
+    d->rebuild();
+}
+
+FreeBusyItemModel *FreeSlotFinder::model() const
+{
+    return d->mModel;
+}
+
+void FreeSlotFinder::setWorkingHours(QTime start, QTime end)
+{
+    d->mWorkingHoursStart = start;
+    d->mWorkingHoursEnd = end;
+    d->scheduleUpdate();
+}
+
+QTime FreeSlotFinder::workingHoursStart() const
+{
+    return d->mWorkingHoursStart;
+}
+
+QTime FreeSlotFinder::workingHoursEnd() const
+{
+    return d->mWorkingHoursEnd;
+}
+
+void FreeSlotFinder::setWorkDaysOnly(bool workDaysOnly)
+{
+    d->mWorkDaysOnly = workDaysOnly;
+    d->scheduleUpdate();
+}
+
+bool FreeSlotFinder::workDaysOnly() const
+{
+    return d->mWorkDaysOnly;
+}
+
+void FreeSlotFinder::setTimeZone(const QTimeZone &timeZone)
+{
+    d->mTimeZone = timeZone;
+    d->scheduleUpdate();
+}
+
+QTimeZone FreeSlotFinder::timeZone() const
+{
+    return d->mTimeZone;
+}
+
+KCalendarCore::Period::List
+FreeSlotFinder::findFreeSlots(const QDateTime &from, const QDateTime &to, const KCalendarCore::Duration &duration, int count) const
+{
+    if (!from.isValid() || !to.isValid() || from >= to || count == 0) {
+        return {};
+    }
+
+    const qint64 fromMs = from.toMSecsSinceEpoch();
+    const qint64 toMs = to.toMSecsSinceEpoch();
+    const bool hasWorkingHours = d->mWorkingHoursStart.isValid() && d->mWorkingHoursEnd.isValid() && d->mWorkingHoursStart < d->mWorkingHoursEnd;
+    SlotCollector collector(duration.asSeconds() * qint64(1000), count, d->mTimeZone);
+
+    // Restricts a free period to the work days and working hours
+    auto addFree = [&](qint64 start, qint64 end) {
+        if (!hasWorkingHours && !d->mWorkDaysOnly) {
+            collector.add(start, end);
+            return;
+        }
+        const QDate lastDay = QDateTime::fromMSecsSinceEpoch(end - 1, d->mTimeZone).date();
+        for (QDate day = QDateTime::fromMSecsSinceEpoch(start, d->mTimeZone).date(); day <= lastDay && !collector.isFull(); day = day.addDays(1)) {
+            if (d->mWorkDaysOnly && !isWorkDay(day)) {
+                continue;
+            }
+            const QDateTime dayStart(day, hasWorkingHours ? d->mWorkingHoursStart : QTime(0, 0), d->mTimeZone);
+            const QDateTime dayEnd = hasWorkingHours ? QDateTime(day, d->mWorkingHoursEnd, d->mTimeZone) : QDateTime(day.addDays(1), QTime(0, 0), d->mTimeZone);
+            collector.add(std::max(start, dayStart.toMSecsSinceEpoch()), std::min(end, dayEnd.toMSecsSinceEpoch()));
+        }
+    };
+
+    // The number of attendees busy at from
+    const QList<std::pair<qint64, int>> &busyCounts = d->busyCounts();
+    auto it = std::upper_bound(busyCounts.cbegin(), busyCounts.cend(), fromMs, [](qint64 time, const std::pair<qint64, int> &count) {
+        return time < count.first;
+    });
+    int busy = it == busyCounts.cbegin() ? 0 : std::prev(it)->second;
+
+    // Sweep over the boundaries within the range
+    qint64 freeStart = fromMs;
+    for (; it != busyCounts.cend() && it->first < toMs && !collector.isFull(); ++it) {
+        const bool wasFree = busy == 0;
+        busy = it->second;
+        if (wasFree && busy != 0) {
+            addFree(freeStart, it->first);
+        } else if (!wasFree && busy == 0) {
+            freeStart = it->first;
+        }
+    }
+    if (busy == 0 && !collector.isFull()) {
+        addFree(freeStart, toMs);
+    }
+
+    return collector.slots();
+}
+
+void FreeSlotFinder::setSearch(const QDateTime &from, const QDateTime &to, const KCalendarCore::Duration &duration, int count)
+{
+    d->mSearchFrom = from;
+    d->mSearchTo = to;
+    d->mSearchDuration = duration;
+    d->mSearchCount = count;
+    d->scheduleUpdate();
+}
+
+#include "moc_freeslotfinder.cpp"
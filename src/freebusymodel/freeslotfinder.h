@@ -0,0 +1,103 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "calendarsupport_export.h"
+
+#include <KCalendarCore/Duration>
+#include <KCalendarCore/Period>
+
+#include <QObject>
+#include <QTime>
+#include <QTimeZone>
+
+#include <memory>
+
+namespace CalendarSupport
+{
+class FreeBusyItemModel;
+class FreeSlotFinderPrivate;
+
+/*!
+ * \class CalendarSupport::FreeSlotFinder
+ * \inmodule CalendarSupport
+ * \inheaderfile CalendarSupport/FreeSlotFinder
+ *
+ * \brief Finds the periods in which all attendees of a FreeBusyItemModel are free.
+ *
+ * The busy periods of all attendees are merged into a sorted set of period
+ * boundaries, which is updated incrementally as the model changes, so that
+ * looking for free slots is a single sweep over the searched range.
+ *
+ * Periods of type KCalendarCore::FreeBusyPeriod::Free do not make an attendee
+ * busy; all other types do. Free slots are restricted to the work days
+ * configured in KCalPrefs and, if set, to the working hours.
+ *
+ * Once a search is set with setSearch(), freePeriodsChanged() is emitted
+ * whenever its result may have changed. It can be connected to
+ * FreePeriodModel::slotNewFreePeriods().
+ *
+ * \since 6.9.0
+ */
+class CALENDARSUPPORT_EXPORT FreeSlotFinder : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FreeSlotFinder(QObject *parent = nullptr);
+    ~FreeSlotFinder() override;
+
+    /*!
+     * Sets the model providing the busy periods of the attendees.
+     */
+    void setModel(FreeBusyItemModel *model);
+    [[nodiscard]] FreeBusyItemModel *model() const;
+
+    /*!
+     * Sets the daily working hours between \a start and \a end in which free slots
+     * are looked for. Invalid times, the default, allow slots at any time of the day.
+     */
+    void setWorkingHours(QTime start, QTime end);
+    [[nodiscard]] QTime workingHoursStart() const;
+    [[nodiscard]] QTime workingHoursEnd() const;
+
+    /*!
+     * Sets whether free slots are only looked for on work days. The default is true.
+     * \sa CalendarSupport::isWorkDay()
+     */
+    void setWorkDaysOnly(bool workDaysOnly);
+    [[nodiscard]] bool workDaysOnly() const;
+
+    /*!
+     * Sets the time zone of the working hours and work days to \a timeZone.
+     * The default is the system time zone.
+     */
+    void setTimeZone(const QTimeZone &timeZone);
+    [[nodiscard]] QTimeZone timeZone() const;
+
+    /*!
+     * Returns the first \a count periods between \a from and \a to in which all
+     * attendees are free, that are at least \a duration long, in time order.
+     * A negative \a count returns all of them.
+     */
+    [[nodiscard]] KCalendarCore::Period::List
+    findFreeSlots(const QDateTime &from, const QDateTime &to, const KCalendarCore::Duration &duration, int count = -1) const;
+
+    /*!
+     * Sets the search whose result is emitted by freePeriodsChanged(), see findFreeSlots().
+     */
+    void setSearch(const QDateTime &from, const QDateTime &to, const KCalendarCore::Duration &duration, int count = -1);
+
+Q_SIGNALS:
+    /*!
+     * Emitted with the result of the search after it changed.
+     */
+    void freePeriodsChanged(const KCalendarCore::Period::List &freePeriods);
+
+private:
+    std::unique_ptr<FreeSlotFinderPrivate> const d;
+};
+}
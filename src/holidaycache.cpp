@@ -0,0 +1,219 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#include "holidaycache.h"
+
+#include "kcalprefs.h"
+
+#include <KHolidays/HolidayRegion>
+
+#include <KLocalizedString>
+
+#include <algorithm>
+
+using namespace CalendarSupport;
+
+Q_GLOBAL_STATIC(HolidayCache, globalHolidayCache)
+
+// Holidays spanning several days are reported at their observed start date, so
+// look back that far before January 1st to catch the ones reaching into the year.
+static constexpr int MaxHolidayLookBack = 31;
+
+HolidayCache::HolidayCache() = default;
+
+HolidayCache::~HolidayCache() = default;
+
+HolidayCache *HolidayCache::instance()
+{
+    return globalHolidayCache;
+}
+
+void HolidayCache::syncWithPrefs()
+{
+    const KCalPrefs *prefs = KCalPrefs::instance();
+
+    if (!mInitialized || prefs->mHolidays != mHolidayRegions) {
+        mRegions.clear();
+        mHolidayRegions = prefs->mHolidays;
+        for (const QString &regionStr : std::as_const(mHolidayRegions)) {
+            auto region = std::make_unique<KHolidays::HolidayRegion>(regionStr);
+            if (region->isValid()) {
+                mRegions.push_back(Region{std::move(region), {}, {}});
+            }
+        }
+        mWorkDays.clear();
+        mInitialized = true;
+    }
+
+    if (prefs->mWorkWeekMask != mWorkWeekMask || prefs->mExcludeHolidays != mExcludeHolidays) {
+        mWorkWeekMask = prefs->mWorkWeekMask;
+        mExcludeHolidays = prefs->mExcludeHolidays;
+        mWorkDays.clear();
+    }
+}
+
+void HolidayCache::setRegionCategories(Region &region, const QStringList &categories)
+{
+    if (region.categories != categories) {
+        region.region->setCategories(categories);
+        region.categories = categories;
+    }
+}
+
+const HolidayCache::YearBits &HolidayCache::regionYear(Region &region, int year)
+{
+    auto it = region.years.find(year);
+    if (it != region.years.end()) {
+        return *it;
+    }
+
+    YearBits bits;
+    // The bits cover all categories, filtering happens when the names are looked up.
+    setRegionCategories(region, {});
+    const QDate first(year, 1, 1);
+    const QDate last(year, 12, 31);
+    const auto list = region.region->rawHolidaysWithAstroSeasons(first.addDays(-MaxHolidayLookBack), last);
+    for (const auto &h : list) {
+        const bool nonWorkDay = (h.dayType() == KHolidays::Holiday::NonWorkday);
+        const int duration = std::max(h.duration(), 1);
+        for (int i = 0; i < duration; ++i) {
+            const QDate date = h.observedStartDate().addDays(i);
+            if (date.year() != year) {
+                continue;
+            }
+            const int day = date.dayOfYear() - 1;
+            bits.holidays.set(day);
+            if (nonWorkDay) {
+                bits.nonWorkDays.set(day);
+            }
+        }
+    }
+    return *region.years.insert(year, bits);
+}
+
+const HolidayCache::DayBits &HolidayCache::workDayBits(int year)
+{
+    auto it = mWorkDays.find(year);
+    if (it != mWorkDays.end()) {
+        return *it;
+    }
+
+    DayBits bits;
+    QDate date(year, 1, 1);
+    const int days = date.daysInYear();
+    for (int day = 0; day < days; ++day, date = date.addDays(1)) {
+        if (mWorkWeekMask & (1 << (date.dayOfWeek() - 1))) {
+            bits.set(day);
+        }
+    }
+    if (mExcludeHolidays) {
+        for (Region &region : mRegions) {
+            bits &= ~regionYear(region, year).nonWorkDays;
+        }
+    }
+    return *mWorkDays.insert(year, bits);
+}
+
+bool HolidayCache::isWorkDay(QDate date)
+{
+    if (!date.isValid()) {
+        return false;
+    }
+    syncWithPrefs();
+    return workDayBits(date.year()).test(date.dayOfYear() - 1);
+}
+
+QList<QDate> HolidayCache::workDays(QDate start, QDate end)
+{
+    QList<QDate> result;
+    if (!start.isValid() || !end.isValid() || start > end) {
+        return result;
+    }
+
+    syncWithPrefs();
+    result.reserve(start.daysTo(end) + 1);
+    for (QDate date = start; date <= end; date = date.addDays(1)) {
+        if (workDayBits(date.year()).test(date.dayOfYear() - 1)) {
+            result.append(date);
+        }
+    }
+    return result;
+}
+
+QStringList HolidayCache::holidays(QDate date, const QStringList &categories)
+{
+    if (!date.isValid()) {
+        return {};
+    }
+
+    syncWithPrefs();
+    const int day = date.dayOfYear() - 1;
+    const bool hasHoliday = std::any_of(mRegions.begin(), mRegions.end(), [this, date, day](Region &region) {
+        return regionYear(region, date.year()).holidays.test(day);
+    });
+    if (!hasHoliday) {
+        return {};
+    }
+    return holidays(date, date, categories).constFirst();
+}
+
+QList<QStringList> HolidayCache::holidays(QDate from, QDate to, const QStringList &categories)
+{
+    QList<QStringList> table;
+    if (!from.isValid() || !to.isValid() || from > to) {
+        return table;
+    }
+
+    syncWithPrefs();
+    const qsizetype days = from.daysTo(to) + 1;
+    table.resize(days);
+
+    // Per day, the position of each holiday name in the day's list, and whether the name
+    // still carries a country code.
+    struct NameEntry {
+        qsizetype index;
+        bool withCountryCode;
+    };
+    std::vector<QHash<QString, NameEntry>> names(days);
+
+    const bool showCountryCode = (mHolidayRegions.count() > 1);
+    for (Region &region : mRegions) {
+        setRegionCategories(region, categories);
+        const KHolidays::Holiday::List list = region.region->rawHolidaysWithAstroSeasons(from.addDays(-MaxHolidayLookBack), to);
+        for (const KHolidays::Holiday &h : list) {
+            const QString name = h.name();
+            const int duration = std::max(h.duration(), 1);
+            for (int i = 0; i < duration; ++i) {
+                const qsizetype offset = from.daysTo(h.observedStartDate().addDays(i));
+                if (offset < 0 || offset >= days) {
+                    continue;
+                }
+                // don't add duplicates.
+                // TODO: won't find duplicates in different languages however.
+                QStringList &dayList = table[offset];
+                auto &dayNames = names[offset];
+                auto it = dayNames.find(name);
+                if (it == dayNames.end()) {
+                    if (showCountryCode) {
+                        // If more than one holiday region, append the country code to the holiday
+                        // display name to help the user identify which region it belongs to.
+                        dayList.append(i18n("%1 (%2)", name, region.region->countryCode()));
+                    } else {
+                        dayList.append(name);
+                    }
+                    dayNames.insert(name, NameEntry{dayList.size() - 1, showCountryCode});
+                } else if (it->withCountryCode) {
+                    // More than 1 region has the same holiday => remove the country code
+                    // i.e don't show "Holiday (US)" and "Holiday(FR)"; just show "Holiday".
+                    dayList[it->index] = name;
+                    it->withCountryCode = false;
+                }
+            }
+        }
+    }
+
+    return table;
+}
@@ -0,0 +1,97 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#pragma once
+
+#include <QDate>
+#include <QHash>
+#include <QStringList>
+
+#include <bitset>
+#include <memory>
+#include <vector>
+
+namespace KHolidays
+{
+class HolidayRegion;
+}
+
+namespace CalendarSupport
+{
+/*!
+ * \internal
+ *
+ * Process-wide cache of the holiday regions configured in KCalPrefs.
+ *
+ * Each region in KCalPrefs::mHolidays is parsed once. For every year that is
+ * asked for, the holidays and non-working days of each region are stored as
+ * one bit per day, and the resulting work days are merged into a single bit
+ * per day, so that workDays(), isWorkDay() and holiday() are plain lookups.
+ *
+ * The cache notices when KCalPrefs::mHolidays, KCalPrefs::mWorkWeekMask or
+ * KCalPrefs::mExcludeHolidays change and drops the affected data.
+ */
+class HolidayCache
+{
+public:
+    HolidayCache();
+    ~HolidayCache();
+
+    static HolidayCache *instance();
+
+    /*!
+     * Returns true if \a date is a work day according to the work week mask
+     * and, if holidays are excluded, the configured holiday regions.
+     */
+    [[nodiscard]] bool isWorkDay(QDate date);
+
+    /*!
+     * Returns the work days between \a start and \a end (inclusive).
+     */
+    [[nodiscard]] QList<QDate> workDays(QDate start, QDate end);
+
+    /*!
+     * Returns the names of the holidays at \a date in any of the configured regions,
+     * restricted to \a categories if that is not empty.
+     */
+    [[nodiscard]] QStringList holidays(QDate date, const QStringList &categories);
+
+    /*!
+     * Returns the names of the holidays between \a from and \a to (inclusive), as
+     * a list with one entry per day, starting at \a from.
+     * Each region's rules are evaluated once for the whole range.
+     */
+    [[nodiscard]] QList<QStringList> holidays(QDate from, QDate to, const QStringList &categories);
+
+private:
+    using DayBits = std::bitset<366>;
+
+    struct YearBits {
+        DayBits holidays;
+        DayBits nonWorkDays;
+    };
+
+    struct Region {
+        std::unique_ptr<KHolidays::HolidayRegion> region;
+        QStringList categories; // the categories currently set on region
+        QHash<int, YearBits> years;
+    };
+
+    void syncWithPrefs();
+    const YearBits &regionYear(Region &region, int year);
+    const DayBits &workDayBits(int year);
+    void setRegionCategories(Region &region, const QStringList &categories);
+
+    std::vector<Region> mRegions;
+    QHash<int, DayBits> mWorkDays;
+
+    // The preferences the cached data was computed from.
+    QStringList mHolidayRegions;
+    int mWorkWeekMask = -1;
+    bool mExcludeHolidays = false;
+    bool mInitialized = false;
+};
+}
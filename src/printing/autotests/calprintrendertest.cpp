@@ -0,0 +1,300 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "calprintrendertest.h"
+#include "../calprinter.h"
+
+#include <KCalendarCore/Event>
+#include <KCalendarCore/Journal>
+#include <KCalendarCore/MemoryCalendar>
+#include <KCalendarCore/Todo>
+
+#include <QBuffer>
+#include <QFile>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QPrinter>
+#include <QRegularExpression>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <functional>
+
+using namespace CalendarSupport;
+using namespace Qt::Literals::StringLiterals;
+
+QTEST_MAIN(CalPrintRenderTest)
+
+static const QDate FirstDay(2026, 3, 2);
+
+// Returns a calendar with a few events, to-dos and journals on each day of March 2026
+static KCalendarCore::Calendar::Ptr makeCalendar()
+{
+    KCalendarCore::Calendar::Ptr const calendar(new KCalendarCore::MemoryCalendar(QTimeZone::systemTimeZone()));
+    for (QDate day(2026, 3, 1); day.month() == 3; day = day.addDays(1)) {
+        for (int hour = 9; hour < 17; hour += 3) {
+            KCalendarCore::Event::Ptr const event(new KCalendarCore::Event);
+            event->setSummary(u"Meeting %1"_s.arg(hour));
+            event->setDescription(u"Discuss the agenda of %1 with the whole team"_s.arg(day.toString(Qt::ISODate)));
+            event->setDtStart(QDateTime(day, QTime(hour, 0), QTimeZone::systemTimeZone()));
+            event->setDtEnd(QDateTime(day, QTime(hour + 1, 30), QTimeZone::systemTimeZone()));
+            calendar->addEvent(event);
+        }
+
+        KCalendarCore::Todo::Ptr const todo(new KCalendarCore::Todo);
+        todo->setSummary(u"Task of %1"_s.arg(day.toString(Qt::ISODate)));
+        todo->setDtDue(QDateTime(day, QTime(17, 0), QTimeZone::systemTimeZone()));
+        calendar->addTodo(todo);
+
+        KCalendarCore::Journal::Ptr const journal(new KCalendarCore::Journal);
+        journal->setSummary(u"Notes"_s);
+        journal->setDescription(u"What happened on %1"_s.arg(day.toString(Qt::ISODate)));
+        journal->setDtStart(QDateTime(day, QTime(18, 0), QTimeZone::systemTimeZone()));
+        calendar->addJournal(journal);
+    }
+    return calendar;
+}
+
+// Adds count journals to the first printed day of calendar
+static void addJournals(const KCalendarCore::Calendar::Ptr &calendar, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        KCalendarCore::Journal::Ptr const journal(new KCalendarCore::Journal);
+        journal->setSummary(u"More notes %1"_s.arg(i));
+        journal->setDescription(u"Another thing that happened"_s);
+        journal->setDtStart(QDateTime(FirstDay, QTime(19, 0), QTimeZone::systemTimeZone()));
+        calendar->addJournal(journal);
+    }
+}
+
+// Returns the number of pages of the PDF document pdf
+static qsizetype pdfPageCount(const QByteArray &pdf)
+{
+    return QString::fromLatin1(pdf).count(QRegularExpression(u"/Type\\s*/Page(?!s)"_s));
+}
+
+static void addStyleRows()
+{
+    QTest::addColumn<int>("type");
+    QTest::addColumn<int>("days");
+    // Whether the printout has a page per day, week or month of several of them
+    QTest::addColumn<bool>("multiPage");
+
+    QTest::newRow("day") << int(CalPrinterBase::Day) << 3 << true;
+    QTest::newRow("week") << int(CalPrinterBase::Week) << 14 << true;
+    QTest::newRow("month") << int(CalPrinterBase::Month) << 40 << true;
+    QTest::newRow("todo") << int(CalPrinterBase::Todolist) << 28 << false;
+    QTest::newRow("year") << int(CalPrinterBase::Year) << 28 << false;
+    QTest::newRow("journal") << int(CalPrinterBase::Journallist) << 28 << false;
+    QTest::newRow("incidence") << int(CalPrinterBase::Incidence) << 1 << false;
+}
+
+static PrintPlugin::RenderOptions renderOptions(const KCalendarCore::Calendar::Ptr &calendar, int type)
+{
+    PrintPlugin::RenderOptions options;
+    if (type == CalPrinterBase::Incidence) {
+        options.selectedIncidences = calendar->incidences(FirstDay);
+    }
+    return options;
+}
+
+void CalPrintRenderTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void CalPrintRenderTest::testRenderPages_data()
+{
+    addStyleRows();
+}
+
+void CalPrintRenderTest::testRenderPages()
+{
+    QFETCH(int, type);
+    QFETCH(int, days);
+    QFETCH(bool, multiPage);
+
+    const KCalendarCore::Calendar::Ptr calendar = makeCalendar();
+    CalPrinter printer(nullptr, calendar);
+    PrintPlugin *plugin = printer.printPlugin(type);
+    QVERIFY(plugin);
+
+    const QPageLayout layout(QPageSize(QPageSize::A4), plugin->defaultOrientation(), QMarginsF(10, 10, 10, 10), QPageLayout::Millimeter);
+    const QList<QPicture> pages = plugin->renderPages(layout, FirstDay, FirstDay.addDays(days - 1), renderOptions(calendar, type));
+    QVERIFY(!pages.isEmpty());
+    if (multiPage) {
+        // Each new page is recorded into a picture of its own
+        QVERIFY(pages.size() > 1);
+    }
+    for (const QPicture &page : pages) {
+        QVERIFY(!page.isNull());
+        QCOMPARE(page.boundingRect().size(), layout.paintRectPixels(page.logicalDpiX()).size());
+    }
+}
+
+void CalPrintRenderTest::testRenderImages_data()
+{
+    addStyleRows();
+}
+
+void CalPrintRenderTest::testRenderImages()
+{
+    QFETCH(int, type);
+    QFETCH(int, days);
+
+    const KCalendarCore::Calendar::Ptr calendar = makeCalendar();
+    CalPrinter printer(nullptr, calendar);
+    PrintPlugin *plugin = printer.printPlugin(type);
+    QVERIFY(plugin);
+
+    // 72 dpi, so that the images have the size of the page in points
+    const QPageLayout layout(QPageSize(QPageSize::A4), QPageLayout::Portrait, QMarginsF());
+    const QDate to = FirstDay.addDays(days - 1);
+    const QList<QImage> images = plugin->renderImages(layout, 72, FirstDay, to, renderOptions(calendar, type));
+    const QList<QPicture> pages = plugin->renderPages(layout, FirstDay, to, renderOptions(calendar, type));
+    QCOMPARE(images.size(), pages.size());
+    for (qsizetype i = 0; i < images.size(); ++i) {
+        const QImage &image = images.at(i);
+        QVERIFY(qAbs(image.width() - QPageSize(QPageSize::A4).sizePoints().width()) <= 1);
+        QVERIFY(qAbs(image.height() - QPageSize(QPageSize::A4).sizePoints().height()) <= 1);
+        QVERIFY(image.pixelColor(0, 0) == Qt::white);
+
+        // The pages rasterized in parallel are those rasterized one by one here,
+        // and not blank
+        QImage expected(image.size(), QImage::Format_RGB32);
+        expected.setDotsPerMeterX(image.dotsPerMeterX());
+        expected.setDotsPerMeterY(image.dotsPerMeterY());
+        expected.fill(Qt::white);
+        const QImage blank = expected.copy();
+        QPainter p(&expected);
+        p.setRenderHint(QPainter::Antialiasing);
+        p.scale(72.0 / pages.at(i).logicalDpiX(), 72.0 / pages.at(i).logicalDpiY());
+        p.drawPicture(0, 0, pages.at(i));
+        p.end();
+        QCOMPARE(image, expected);
+        QVERIFY(image != blank);
+    }
+}
+
+void CalPrintRenderTest::testRenderPdf_data()
+{
+    addStyleRows();
+}
+
+void CalPrintRenderTest::testRenderPdf()
+{
+    QFETCH(int, type);
+    QFETCH(int, days);
+
+    const KCalendarCore::Calendar::Ptr calendar = makeCalendar();
+    CalPrinter printer(nullptr, calendar);
+    PrintPlugin *plugin = printer.printPlugin(type);
+    QVERIFY(plugin);
+
+    const QPageLayout layout(QPageSize(QPageSize::A4), plugin->defaultOrientation(), QMarginsF());
+    const QDate to = FirstDay.addDays(days - 1);
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    {
+        QPdfWriter writer(&buffer);
+        writer.setPageLayout(layout);
+        QVERIFY(plugin->render(&writer, FirstDay, to, renderOptions(calendar, type)));
+    }
+    QVERIFY(buffer.data().startsWith("%PDF"));
+
+    // All pages made it into the document, with some content each
+    QCOMPARE(pdfPageCount(buffer.data()), plugin->renderPages(layout, FirstDay, to, renderOptions(calendar, type)).size());
+    QVERIFY(QString::fromLatin1(buffer.data()).count(QRegularExpression(u"/Type\\s*/Font\\b"_s)) > 0);
+}
+
+void CalPrintRenderTest::testPrintPreview()
+{
+    const KCalendarCore::Calendar::Ptr calendar = makeCalendar();
+    CalPrinter calPrinter(nullptr, calendar);
+    PrintPlugin *plugin = calPrinter.printPlugin(CalPrinterBase::Journallist);
+    QVERIFY(plugin);
+    plugin->setDateRange(FirstDay, FirstDay.addDays(27));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QPrinter printer;
+    printer.setOutputFormat(QPrinter::PdfFormat);
+    printer.setOutputFileName(dir.filePath(u"preview.pdf"_s));
+    printer.setPageLayout(QPageLayout(QPageSize(QPageSize::A4), QPageLayout::Portrait, QMarginsF()));
+
+    // Paints the preview and returns its number of pages
+    auto preview = [&]() -> qsizetype {
+        plugin->doPrintPreview(&printer);
+        QFile file(printer.outputFileName());
+        return file.open(QIODevice::ReadOnly) ? pdfPageCount(file.readAll()) : 0;
+    };
+
+    // The journals added behind the plugin's back only show up once the pages are
+    // laid out again, rather than replayed
+    const qsizetype pages = preview();
+    QVERIFY(pages > 0);
+    addJournals(calendar, 200);
+    QCOMPARE(preview(), pages);
+
+    // A different page layout is laid out again
+    printer.setPageOrientation(QPageLayout::Landscape);
+    QVERIFY(preview() > pages);
+    printer.setPageOrientation(QPageLayout::Portrait);
+    qsizetype current = preview();
+    QVERIFY(current > pages);
+    addJournals(calendar, 200);
+    QCOMPARE(preview(), current);
+
+    // So is the printout after a change of its settings
+    const std::function<void()> changes[] = {
+        [&]() {
+            plugin->setDateRange(FirstDay, FirstDay.addDays(27));
+        },
+        [&]() {
+            plugin->setSelectedIncidences({});
+        },
+        [&]() {
+            plugin->setCalendar(calendar);
+        },
+        [&]() {
+            plugin->doSaveConfig();
+        },
+    };
+    for (const auto &change : changes) {
+        change();
+        const qsizetype changed = preview();
+        QVERIFY(changed > current);
+        current = changed;
+        addJournals(calendar, 200);
+        QCOMPARE(preview(), current);
+    }
+}
+
+void CalPrintRenderTest::benchmarkRender_data()
+{
+    addStyleRows();
+}
+
+void CalPrintRenderTest::benchmarkRender()
+{
+    QFETCH(int, type);
+    QFETCH(int, days);
+
+    const KCalendarCore::Calendar::Ptr calendar = makeCalendar();
+    CalPrinter printer(nullptr, calendar);
+    PrintPlugin *plugin = printer.printPlugin(type);
+    QVERIFY(plugin);
+
+    const QPageLayout layout(QPageSize(QPageSize::A4), plugin->defaultOrientation(), QMarginsF());
+    const PrintPlugin::RenderOptions options = renderOptions(calendar, type);
+    QBENCHMARK {
+        const QList<QPicture> pages = plugin->renderPages(layout, FirstDay, FirstDay.addDays(days - 1), options);
+        QVERIFY(!pages.isEmpty());
+    }
+}
+
+#include "moc_calprintrendertest.cpp"
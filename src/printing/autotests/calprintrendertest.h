@@ -0,0 +1,28 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QObject>
+
+namespace CalendarSupport
+{
+class CalPrintRenderTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testRenderPages_data();
+    void testRenderPages();
+    void testRenderImages_data();
+    void testRenderImages();
+    void testRenderPdf_data();
+    void testRenderPdf();
+    void testPrintPreview();
+    void benchmarkRender_data();
+    void benchmarkRender();
+};
+}
@@ -0,0 +1,105 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "cellitemtest.h"
+#include "../../cellitem.h"
+
+#include <QTest>
+
+#include <memory>
+#include <vector>
+
+using namespace CalendarSupport;
+
+QTEST_GUILESS_MAIN(CellItemTest)
+
+namespace
+{
+// An item covering [start, end)
+class RangeItem : public CellItem
+{
+public:
+    RangeItem(qint64 start, qint64 end)
+        : mStart(start)
+        , mEnd(end)
+    {
+    }
+
+    bool overlaps(CellItem *o) const override
+    {
+        const auto other = static_cast<RangeItem *>(o);
+        return !(other->mStart >= mEnd || other->mEnd <= mStart);
+    }
+
+    [[nodiscard]] qint64 extentStart() const override
+    {
+        return mStart;
+    }
+
+    [[nodiscard]] qint64 extentEnd() const override
+    {
+        return mEnd;
+    }
+
+private:
+    const qint64 mStart;
+    const qint64 mEnd;
+};
+
+using Ranges = QList<std::pair<qint64, qint64>>;
+using Placement = QList<std::pair<int, int>>;
+
+// Lays out the ranges with placeItems(), or with placeItem() for each of them in order,
+// and returns the sub-cell and number of sub-cells of each
+Placement place(const Ranges &ranges, bool all)
+{
+    std::vector<std::unique_ptr<RangeItem>> items;
+    QList<CellItem *> cells;
+    for (const auto &[start, end] : ranges) {
+        items.push_back(std::make_unique<RangeItem>(start, end));
+        cells.append(items.back().get());
+    }
+    if (all) {
+        CellItem::placeItems(cells);
+    } else {
+        for (CellItem *cell : std::as_const(cells)) {
+            CellItem::placeItem(cells, cell);
+        }
+    }
+    Placement placement;
+    for (const CellItem *cell : std::as_const(cells)) {
+        placement.append({cell->subCell(), cell->subCells()});
+    }
+    return placement;
+}
+}
+
+void CellItemTest::testPlaceItems_data()
+{
+    QTest::addColumn<Ranges>("ranges");
+    QTest::addColumn<Placement>("placement");
+
+    QTest::newRow("disjoint") << Ranges{{0, 2}, {2, 4}, {6, 8}} << Placement{{0, 1}, {0, 1}, {0, 1}};
+    QTest::newRow("nested") << Ranges{{0, 10}, {2, 4}, {3, 8}} << Placement{{0, 3}, {1, 3}, {2, 3}};
+    QTest::newRow("reused sub-cell") << Ranges{{0, 10}, {0, 2}, {5, 10}} << Placement{{0, 2}, {1, 2}, {1, 2}};
+    QTest::newRow("shorter first") << Ranges{{0, 2}, {0, 10}, {5, 10}} << Placement{{0, 2}, {1, 2}, {0, 2}};
+    QTest::newRow("equal starts") << Ranges{{0, 4}, {0, 8}, {0, 2}, {2, 6}} << Placement{{0, 3}, {1, 3}, {2, 3}, {2, 3}};
+    QTest::newRow("empty at start") << Ranges{{0, 10}, {5, 8}, {5, 5}} << Placement{{0, 2}, {1, 2}, {1, 2}};
+    QTest::newRow("two groups") << Ranges{{0, 4}, {1, 3}, {4, 6}, {5, 9}, {5, 7}}
+                                << Placement{{0, 2}, {1, 2}, {0, 3}, {1, 3}, {2, 3}};
+}
+
+void CellItemTest::testPlaceItems()
+{
+    QFETCH(Ranges, ranges);
+    QFETCH(Placement, placement);
+
+    // The ranges are in order of their start, so both must place them alike
+    QCOMPARE(place(ranges, false), placement);
+    QCOMPARE(place(ranges, true), placement);
+}
+
+#include "moc_cellitemtest.cpp"
@@ -186,8 +186,8 @@ protected:
 
 int CalPrintIncidence::printCaptionAndText(QPainter &p, QRect box, const QString &caption, const QString &text, const QFont &captionFont, const QFont &textFont)
 {
-    QFontMetrics const captionFM(captionFont);
-    int const textWd = captionFM.horizontalAdvance(caption);
+    PrintStyleCache::Font &captionStyle = mStyles.font(captionFont);
+    int const textWd = captionStyle.horizontalAdvance(caption);
     QRect textRect(box);
 
     QFont const oldFont(p.font());
@@ -220,7 +220,7 @@ void CalPrintIncidence::print(QPainter &p, int width, int height)
             continue;
         }
         if (it != mSelectedIncidences.constBegin()) {
-            mPrinter->newPage();
+            newPage(p);
         }
 
         const bool isJournal = ((*it)->type() == KCalendarCore::Incidence::TypeJournal);
@@ -730,11 +730,11 @@ static QString cleanString(const QString &instr)
     return ret.replace(u'\n', u' ');
 }
 
-void CalPrintTimetable::drawAllDayBox(QPainter &p, const KCalendarCore::Event::List &eventList, QDate qd, QRect box, const QList<QDate> &workDays)
+void CalPrintTimetable::drawAllDayBox(QPainter &p, const KCalendarCore::Event::List &eventList, QDate qd, QRect box)
 {
     int const lineSpacing = p.fontMetrics().lineSpacing();
 
-    if (!workDays.contains(qd)) {
+    if (!isWorkDay(qd)) {
         drawShadedBox(p, BOX_BORDER_WIDTH, sHolidayBackground, box);
     } else {
         drawBox(p, BOX_BORDER_WIDTH, box);
@@ -770,9 +770,11 @@ void CalPrintTimetable::drawTimeTable(QPainter &p, QDate fromDate, QDate toDate,
     QTime myToTime = mEndTime;
     int maxAllDayEvents = 0;
     QDate curDate(fromDate);
+    loadHolidays(fromDate, toDate);
+    loadOccurrences(fromDate, toDate);
     while (curDate <= toDate) {
-        KCalendarCore::Event::List eventList = mCalendar->events(curDate, QTimeZone::systemTimeZone());
-        int allDayEvents = holiday(curDate).isEmpty() ? 0 : 1;
+        const KCalendarCore::Event::List eventList = eventsForDate(curDate);
+        int allDayEvents = holidayString(curDate).isEmpty() ? 0 : 1;
         for (const KCalendarCore::Event::Ptr &event : std::as_const(eventList)) {
             Q_ASSERT(event);
             if (!event || (mExcludeConfidential && event->secrecy() == KCalendarCore::Incidence::SecrecyConfidential)
@@ -796,7 +798,7 @@ void CalPrintTimetable::drawTimeTable(QPainter &p, QDate fromDate, QDate toDate,
         curDate = curDate.addDays(1);
     }
 
-    p.setFont(QFont(u"sans-serif"_s, 11, QFont::Normal));
+    p.setFont(mStyles.font(11, QFont::Normal).font);
     const int lineSpacing = p.fontMetrics().lineSpacing();
 
     int const timelineWidth = TIMELINE_WIDTH + padding();
@@ -813,7 +815,7 @@ void CalPrintTimetable::drawTimeTable(QPainter &p, QDate fromDate, QDate toDate,
         // Draw the side bar for all-day events.
         const auto alldayLabel = i18nc("label for timetable all-day boxes", "All day");
         const QFont oldFont(p.font());
-        p.setFont(QFont(u"sans-serif"_s, 9, QFont::Normal));
+        p.setFont(mStyles.font(9, QFont::Normal).font);
         const auto labelHeight = p.fontMetrics().horizontalAdvance(alldayLabel) + 2 * padding();
         alldayHeight = std::max(maxAllDayEvents * lineSpacing + 2 * padding(), labelHeight);
         drawVerticalBox(p,
@@ -835,10 +837,8 @@ void CalPrintTimetable::drawTimeTable(QPainter &p, QDate fromDate, QDate toDate,
     int i = 0;
     double const cellWidth = double(dowBox.width() - 1) / double(fromDate.daysTo(toDate) + 1);
     QRect allDayBox(dowBox.left(), dowBox.bottom(), cellWidth, alldayHeight);
-    const QList<QDate> workDays = CalendarSupport::workDays(fromDate, toDate);
     while (curDate <= toDate) {
-        KCalendarCore::Event::List eventList =
-            mCalendar->events(curDate, QTimeZone::systemTimeZone(), KCalendarCore::EventSortStartDate, KCalendarCore::SortDirectionAscending);
+        KCalendarCore::Event::List eventList = eventsForDate(curDate);
 
         allDayBox.setLeft(dowBox.left() + int(i * cellWidth));
         allDayBox.setRight(dowBox.left() + int((i + 1) * cellWidth));
@@ -846,13 +846,13 @@ void CalPrintTimetable::drawTimeTable(QPainter &p, QDate fromDate, QDate toDate,
             if (const auto h = holidayEvent(curDate)) {
                 eventList.prepend(h);
             }
-            drawAllDayBox(p, eventList, curDate, allDayBox, workDays);
+            drawAllDayBox(p, eventList, curDate, allDayBox);
         }
 
         QRect dayBox(allDayBox);
         dayBox.setTop(tlTop);
         dayBox.setBottom(box.bottom());
-        drawAgendaDayBox(p, eventList, curDate, false, myFromTime, myToTime, dayBox, mIncludeDescription, mIncludeCategories, mExcludeTime, workDays);
+        drawAgendaDayBox(p, eventList, curDate, false, myFromTime, myToTime, dayBox, mIncludeDescription, mIncludeCategories, mExcludeTime);
 
         ++i;
         curDate = curDate.addDays(1);
@@ -986,6 +986,8 @@ void CalPrintDay::drawDays(QPainter &p, QRect box)
     }
     const int cellHeight = box.height() / vcells;
     QDate weekDate = mFromDate;
+    loadHolidays(mFromDate, mToDate);
+    loadOccurrences(mFromDate, mToDate);
     for (int i = 0; i < numberOfDays; ++i, weekDate = weekDate.addDays(1)) {
         const int hpos = i / vcells;
         const int vpos = i % vcells;
@@ -997,6 +999,7 @@ void CalPrintDay::drawDays(QPainter &p, QRect box)
 void CalPrintDay::print(QPainter &p, int width, int height)
 {
     QDate curDay(mFromDate);
+    loadOccurrences(mFromDate, mToDate);
 
     QRect const headerBox(0, 0, width, headerHeight());
     QRect const footerBox(0, height - footerHeight(), width, footerHeight());
@@ -1051,7 +1054,7 @@ void CalPrintDay::print(QPainter &p, int width, int height)
 
             curDay = curDay.addDays(1);
             if (curDay <= mToDate) {
-                mPrinter->newPage();
+                newPage(p);
             }
         } while (curDay <= mToDate);
     } // switch
@@ -1198,6 +1201,8 @@ void CalPrintWeek::drawWeek(QPainter &p, QDate qd, QRect box)
     // correct begin of week
     int const weekdayCol = weekdayColumn(qd.dayOfWeek());
     QDate weekDate = qd.addDays(-weekdayCol);
+    loadHolidays(weekDate, weekDate.addDays(6));
+    loadOccurrences(weekDate, weekDate.addDays(6));
 
     for (int i = 0; i < 7; ++i, weekDate = weekDate.addDays(1)) {
         // Saturday and sunday share a cell, so we have to special-case sunday
@@ -1222,6 +1227,7 @@ void CalPrintWeek::print(QPainter &p, int width, int height)
     fromWeek = mFromDate.addDays(-weekdayCol);
     weekdayCol = weekdayColumn(mToDate.dayOfWeek());
     toWeek = mToDate.addDays(6 - weekdayCol);
+    loadOccurrences(fromWeek, toWeek);
 
     curWeek = fromWeek.addDays(6);
     auto local = QLocale::system();
@@ -1253,7 +1259,7 @@ void CalPrintWeek::print(QPainter &p, int width, int height)
 
             curWeek = curWeek.addDays(7);
             if (curWeek <= toWeek) {
-                mPrinter->newPage();
+                newPage(p);
             }
         } while (curWeek <= toWeek);
         break;
@@ -1279,7 +1285,7 @@ void CalPrintWeek::print(QPainter &p, int width, int height)
             fromWeek = fromWeek.addDays(7);
             curWeek = fromWeek.addDays(6);
             if (curWeek <= toWeek) {
-                mPrinter->newPage();
+                newPage(p);
             }
         } while (curWeek <= toWeek);
         break;
@@ -1299,7 +1305,7 @@ void CalPrintWeek::print(QPainter &p, int width, int height)
             if (mPrintFooter) {
                 drawFooter(p, footerBox);
             }
-            mPrinter->newPage();
+            newPage(p);
             drawSplitHeaderRight(p, fromWeek, curWeek, QDate(), width, hh);
             drawTimeTable(p, endLeft.addDays(1), curWeek, weekBox1);
 
@@ -1310,7 +1316,7 @@ void CalPrintWeek::print(QPainter &p, int width, int height)
             fromWeek = fromWeek.addDays(7);
             curWeek = fromWeek.addDays(6);
             if (curWeek <= toWeek) {
-                mPrinter->newPage();
+                newPage(p);
             }
         } while (curWeek <= toWeek);
         break;
@@ -1439,6 +1445,8 @@ void CalPrintMonth::print(QPainter &p, int width, int height)
 
     fromMonth = mFromDate.addDays(-(mFromDate.day() - 1));
     toMonth = mToDate.addDays(mToDate.daysInMonth() - mToDate.day());
+    // the month tables include the days of the neighboring months in their first and last week
+    loadOccurrences(fromMonth.addDays(-weekdayColumn(fromMonth.dayOfWeek())), toMonth.addDays(6));
 
     curMonth = fromMonth;
 
@@ -1475,7 +1483,7 @@ void CalPrintMonth::print(QPainter &p, int width, int height)
 
         curMonth = curMonth.addDays(curMonth.daysInMonth());
         if (curMonth <= toMonth) {
-            mPrinter->newPage();
+            newPage(p);
         }
     } while (curMonth <= toMonth);
 }
@@ -1639,7 +1647,7 @@ void CalPrintTodos::print(QPainter &p, int width, int height)
 
     // Estimate widths of some data columns.
     QFont const oldFont(p.font());
-    p.setFont(QFont(u"sans-serif"_s, 10));
+    p.setFont(mStyles.font(10).font);
     const int widDate = p.fontMetrics().boundingRect(QLocale::system().toString(QDate(2222, 12, 22), QLocale::ShortFormat)).width();
     const int widPct = p.fontMetrics().boundingRect(i18n("%1%", 100)).width() + 27;
 
@@ -1647,7 +1655,7 @@ void CalPrintTodos::print(QPainter &p, int width, int height)
     int mCurrentLinePos = headerHeight() + 5;
     QString outStr;
 
-    p.setFont(QFont(u"sans-serif"_s, 9, QFont::Bold));
+    p.setFont(mStyles.font(9, QFont::Bold).font);
     int const lineSpacing = p.fontMetrics().lineSpacing();
     mCurrentLinePos += lineSpacing;
     int pospriority = -1;
@@ -1698,7 +1706,7 @@ void CalPrintTodos::print(QPainter &p, int width, int height)
         p.drawText(posCategories, mCurrentLinePos - 2, outStr);
     }
 
-    p.setFont(QFont(u"sans-serif"_s, 10));
+    p.setFont(mStyles.font(10).font);
 
     KCalendarCore::Todo::List todoList;
     KCalendarCore::Todo::List tempList;
@@ -1769,6 +1777,7 @@ void CalPrintTodos::print(QPainter &p, int width, int height)
     }
 
     // Print to-dos
+    TodoTree todoTree(todoList);
     int count = 0;
     for (const KCalendarCore::Todo::Ptr &todo : std::as_const(todoList)) {
         // Skip sub-to-dos. They will be printed recursively in drawTodo()
@@ -1793,7 +1802,7 @@ void CalPrintTodos::print(QPainter &p, int width, int height)
                      mCurrentLinePos,
                      width,
                      height,
-                     todoList,
+                     todoTree,
                      nullptr);
         }
     }
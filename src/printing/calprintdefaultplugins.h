@@ -130,9 +130,8 @@ protected:
              inside this box
       \a qd The date of the currently printed day
       \a box coordinates of the all day box.
-      \a workDays List of workDays
     */
-    void drawAllDayBox(QPainter &p, const KCalendarCore::Event::List &eventList, QDate qd, QRect box, const QList<QDate> &workDays);
+    void drawAllDayBox(QPainter &p, const KCalendarCore::Event::List &eventList, QDate qd, QRect box);
 
     /*!
       Draw the timetable view of the given time range from fromDate to toDate.
@@ -21,12 +21,15 @@ using namespace Qt::Literals::StringLiterals;
 #include <QDialogButtonBox>
 #include <QGridLayout>
 #include <QGroupBox>
+#include <QPaintEngine>
 #include <QPrintDialog>
 #include <QPrintPreviewDialog>
 #include <QSplitter>
 #include <QStackedWidget>
 #include <QVBoxLayout>
 
+#include <algorithm>
+
 using namespace CalendarSupport;
 
 CalPrinter::CalPrinter(QWidget *parent, const KCalendarCore::Calendar::Ptr &calendar, bool uniqItem)
@@ -134,8 +137,16 @@ void CalPrinter::doPrint(PrintPlugin *selectedStyle, CalPrinter::ePrintOrientati
     if (preview) {
         QPointer<QPrintPreviewDialog> const printPreview = new QPrintPreviewDialog(&printer);
         new KWindowStateSaver(printPreview.data(), "CalendarPrintPreviewDialog"_L1);
-        connect(printPreview.data(), &QPrintPreviewDialog::paintRequested, this, [selectedStyle, &printer]() {
-            selectedStyle->doPrint(&printer);
+        connect(printPreview.data(), &QPrintPreviewDialog::paintRequested, this, [selectedStyle](QPrinter *printer) {
+            // Printing from the preview requests painting too, into the real printer
+            // rather than the preview's paint engine. It gets a printout of its own
+            // instead of the pages recorded at screen resolution for the preview.
+            const QPaintEngine *engine = printer->paintEngine();
+            if (engine && engine->type() == QPaintEngine::Picture) {
+                selectedStyle->doPrintPreview(printer);
+            } else {
+                selectedStyle->doPrint(printer);
+            }
         });
         printPreview->exec();
         delete printPreview;
@@ -148,6 +159,14 @@ void CalPrinter::doPrint(PrintPlugin *selectedStyle, CalPrinter::ePrintOrientati
     }
 }
 
+PrintPlugin *CalPrinter::printPlugin(int type) const
+{
+    const auto it = std::find_if(mPrintPlugins.cbegin(), mPrintPlugins.cend(), [type](const PrintPlugin *plugin) {
+        return plugin->sortID() == type;
+    });
+    return it != mPrintPlugins.cend() ? *it : nullptr;
+}
+
 void CalPrinter::updateConfig()
 {
 }
@@ -74,6 +74,13 @@ public:
     KCalendarCore::Calendar::Ptr calendar() const;
     KConfig *config() const;
 
+    /*!
+      Returns the print style of \a type, one of CalPrinterBase::PrintType, or
+      nullptr if there is none. Its PrintPlugin::render() prints without dialogs.
+      \since 6.9.0
+    */
+    [[nodiscard]] PrintPlugin *printPlugin(int type) const;
+
 protected:
     PrintPlugin::List mPrintPlugins;
 
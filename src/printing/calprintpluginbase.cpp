@@ -20,16 +20,17 @@ using namespace Qt::Literals::StringLiterals;
 #include "calendarsupport_debug.h"
 #include <KConfig>
 #include <KConfigGroup>
-#include <KWordWrap>
 
 #include <KLocalizedString>
 #include <QAbstractTextDocumentLayout>
+#include <QFontDatabase>
 #include <QFrame>
 #include <QLabel>
 #include <QLocale>
+#include <QSet>
 #include <QTextCursor>
 #include <QTextDocument>
-#include <QTextDocumentFragment>
+#include <QThreadPool>
 #include <QTimeZone>
 #include <QVBoxLayout>
 #include <qmath.h>
@@ -37,6 +38,7 @@ using namespace Qt::Literals::StringLiterals;
 using namespace CalendarSupport;
 
 #include <cmath>
+#include <utility>
 
 static QString cleanStr(const QString &instr)
 {
@@ -64,6 +66,31 @@ public:
     bool mSamePage;
 };
 
+/******************************************************************
+ **                     The Todo tree                            **
+ ******************************************************************/
+CalPrintPluginBase::TodoTree::TodoTree(const KCalendarCore::Todo::List &todoList)
+{
+    // relations() does not apply filters, so the tree is built from the filtered list only.
+    QSet<const KCalendarCore::Todo *> members;
+    members.reserve(todoList.count());
+    for (const KCalendarCore::Todo::Ptr &todo : todoList) {
+        if (!todo || members.contains(todo.data())) {
+            continue;
+        }
+        members.insert(todo.data());
+        const QString parentUid = todo->relatedTo();
+        if (!parentUid.isEmpty()) {
+            mChildren[parentUid].append(todo);
+        }
+    }
+}
+
+KCalendarCore::Todo::List CalPrintPluginBase::TodoTree::children(const KCalendarCore::Todo::Ptr &todo) const
+{
+    return mChildren.value(todo->uid());
+}
+
 /******************************************************************
  **                     The Print item                           **
  ******************************************************************/
@@ -106,6 +133,16 @@ public:
         return !(other->start() >= end() || other->end() <= start());
     }
 
+    [[nodiscard]] qint64 extentStart() const override
+    {
+        return mStart.toMSecsSinceEpoch();
+    }
+
+    [[nodiscard]] qint64 extentEnd() const override
+    {
+        return mEnd.toMSecsSinceEpoch();
+    }
+
 private:
     KCalendarCore::Event::Ptr mEvent;
     QDateTime mStart, mEnd;
@@ -151,12 +188,27 @@ QWidget *CalPrintPluginBase::createConfigWidget(QWidget *w)
     return wdg;
 }
 
+void CalPrintPluginBase::startPrintJob()
+{
+    // the holiday settings might have changed since the last printout
+    mHolidays.clear();
+    mHolidaysStart = QDate();
+    // ... and so might the calendar
+    mOccurrences.clear();
+    // ... and the fonts
+    mStyles.clear();
+    mTextLayouts.clear();
+}
+
 void CalPrintPluginBase::doPrint(QPrinter *printer)
 {
     if (!printer) {
         return;
     }
     mPrinter = printer;
+    mPaintDevice = printer;
+    mPageLayout = printer->pageLayout();
+    startPrintJob();
     QPainter p;
 
     mPrinter->setColorMode(mUseColors ? QPrinter::Color : QPrinter::GrayScale);
@@ -180,10 +232,193 @@ void CalPrintPluginBase::doPrint(QPrinter *printer)
 
     p.end();
     mPrinter = nullptr;
+    mPaintDevice = nullptr;
+    mPageLayout = QPageLayout();
+}
+
+// Paints the pages into images of resolution dpi, in parallel when fonts can be
+// rendered outside of the GUI thread. Vector output can't be parallelized like
+// this: the pages of a paged device are painted one after another by one painter.
+static QList<QImage> rasterizePages(const QList<QPicture> &pages, int resolution)
+{
+    QList<QImage> images(pages.size());
+    QImage *const image = images.data();
+    auto paintPage = [&pages, image, resolution](qsizetype i) {
+        const QPicture &page = pages.at(i);
+        const qreal scaleX = qreal(resolution) / page.logicalDpiX();
+        const qreal scaleY = qreal(resolution) / page.logicalDpiY();
+        QImage pageImage(qCeil(page.boundingRect().width() * scaleX), qCeil(page.boundingRect().height() * scaleY), QImage::Format_RGB32);
+        pageImage.setDotsPerMeterX(qRound(resolution / 0.0254));
+        pageImage.setDotsPerMeterY(qRound(resolution / 0.0254));
+        pageImage.fill(Qt::white);
+        QPainter p(&pageImage);
+        p.setRenderHint(QPainter::Antialiasing);
+        p.scale(scaleX, scaleY);
+        p.drawPicture(0, 0, page);
+        p.end();
+        image[i] = std::move(pageImage);
+    };
+
+    if (pages.size() < 2 || !QFontDatabase::supportsThreadedFontRendering()) {
+        for (qsizetype i = 0; i < pages.size(); ++i) {
+            paintPage(i);
+        }
+        return images;
+    }
+    // Each page is a picture of its own, so they can be painted independently
+    QThreadPool pool;
+    for (qsizetype i = 0; i < pages.size(); ++i) {
+        pool.start([&paintPage, i]() {
+            paintPage(i);
+        });
+    }
+    pool.waitForDone();
+    return images;
+}
+
+// Paints the pages, or their images of resolution dpi if there are any, into device
+static bool paintPages(QPagedPaintDevice *device, const QList<QPicture> &pages, const QList<QImage> &images = {}, int resolution = 0)
+{
+    QPainter p;
+    if (!p.begin(device)) {
+        qCWarning(CALENDARSUPPORT_LOG) << "Unable to paint the printout to" << device;
+        return false;
+    }
+    // The pages are recorded at the resolution of QPicture, whatever that of the device
+    const int resolutionX = images.isEmpty() ? QPicture().logicalDpiX() : resolution;
+    const int resolutionY = images.isEmpty() ? QPicture().logicalDpiY() : resolution;
+    p.scale(qreal(device->logicalDpiX()) / resolutionX, qreal(device->logicalDpiY()) / resolutionY);
+    p.setRenderHint(QPainter::SmoothPixmapTransform);
+    for (qsizetype i = 0; i < pages.size(); ++i) {
+        if (i > 0) {
+            device->newPage();
+        }
+        if (images.isEmpty()) {
+            p.drawPicture(0, 0, pages.at(i));
+        } else {
+            p.drawImage(0, 0, images.at(i));
+        }
+    }
+    p.end();
+    return true;
+}
+
+void CalPrintPluginBase::doPrintPreview(QPrinter *printer)
+{
+    if (!printer) {
+        return;
+    }
+    // The preview repaints on every change of its page setup or zoom, only the former
+    // changes the layout of the pages
+    if (mPreviewPages.isEmpty() || !printer->pageLayout().isEquivalentTo(mPreviewLayout)) {
+        mPreviewLayout = printer->pageLayout();
+        mPreviewPages = recordPages(mPreviewLayout);
+    }
+    printer->setColorMode(mUseColors ? QPrinter::Color : QPrinter::GrayScale);
+    paintPages(printer, mPreviewPages);
+}
+
+bool CalPrintPluginBase::render(QPagedPaintDevice *device, QDate from, QDate to, const RenderOptions &options)
+{
+    if (!device) {
+        return false;
+    }
+    const QList<QPicture> pages = renderPages(device->pageLayout(), from, to, options);
+    if (options.rasterResolution > 0) {
+        return paintPages(device, pages, rasterizePages(pages, options.rasterResolution), options.rasterResolution);
+    }
+    return paintPages(device, pages);
+}
+
+QList<QPicture> CalPrintPluginBase::renderPages(const QPageLayout &layout, QDate from, QDate to, const RenderOptions &options)
+{
+    const QDate fromDate = mFromDate;
+    const QDate toDate = mToDate;
+    const KCalendarCore::Incidence::List selectedIncidences = mSelectedIncidences;
+    setDateRange(from, to);
+    setSelectedIncidences(options.selectedIncidences);
+
+    const QList<QPicture> pages = recordPages(layout);
+
+    setDateRange(fromDate, toDate);
+    setSelectedIncidences(selectedIncidences);
+    return pages;
+}
+
+QList<QPicture> CalPrintPluginBase::recordPages(const QPageLayout &layout)
+{
+    mPageLayout = layout;
+    startPrintJob();
+
+    mPages = {QPicture()};
+    mPageRect = QRect(QPoint(0, 0), layout.paintRectPixels(mPages.first().logicalDpiX()).size());
+    QPainter p(&mPages.last());
+    // Shrink the page into the margins, like doPrint() does with the viewport
+    int const margins = margin();
+    p.translate(margins, margins);
+    p.scale(qreal(mPageRect.width() - 2 * margins) / mPageRect.width(), qreal(mPageRect.height() - 2 * margins) / mPageRect.height());
+
+    print(p, mPageRect.width(), mPageRect.height());
+
+    p.end();
+    mPages.last().setBoundingRect(mPageRect);
+    mPageLayout = QPageLayout();
+    return std::exchange(mPages, {});
+}
+
+QList<QImage> CalPrintPluginBase::renderImages(const QPageLayout &layout, int resolution, QDate from, QDate to, const RenderOptions &options)
+{
+    return rasterizePages(renderPages(layout, from, to, options), resolution);
+}
+
+void CalPrintPluginBase::newPage(QPainter &p)
+{
+    if (mPaintDevice) {
+        mPaintDevice->newPage();
+        return;
+    }
+
+    // A picture has a single page, so go on with the same painter state in a new one
+    const QTransform transform = p.worldTransform();
+    const QFont font = p.font();
+    const QPen pen = p.pen();
+    const QBrush brush = p.brush();
+    const QBrush background = p.background();
+    const Qt::BGMode backgroundMode = p.backgroundMode();
+    p.end();
+    mPages.last().setBoundingRect(mPageRect);
+
+    mPages.append(QPicture());
+    p.begin(&mPages.last());
+    p.setWorldTransform(transform);
+    p.setFont(font);
+    p.setPen(pen);
+    p.setBrush(brush);
+    p.setBackground(background);
+    p.setBackgroundMode(backgroundMode);
+}
+
+void CalPrintPluginBase::setCalendar(const KCalendarCore::Calendar::Ptr &cal)
+{
+    PrintPlugin::setCalendar(cal);
+    mPreviewPages.clear();
+}
+
+void CalPrintPluginBase::setSelectedIncidences(const KCalendarCore::Incidence::List &inc)
+{
+    PrintPlugin::setSelectedIncidences(inc);
+    mPreviewPages.clear();
+}
+
+void CalPrintPluginBase::setDateRange(const QDate &from, const QDate &to)
+{
+    PrintPlugin::setDateRange(from, to);
+    mPreviewPages.clear();
 }
 
 void CalPrintPluginBase::doLoadConfig()
 {
+    mPreviewPages.clear();
     if (mConfig) {
         KConfigGroup const group(mConfig, groupName());
         mConfig->sync();
@@ -202,6 +437,8 @@ void CalPrintPluginBase::doLoadConfig()
 
 void CalPrintPluginBase::doSaveConfig()
 {
+    // The settings are saved once they are read from the dialog
+    mPreviewPages.clear();
     if (mConfig) {
         KConfigGroup group(mConfig, groupName());
         QDateTime dt = QDateTime::currentDateTime(); // any valid QDateTime will do
@@ -228,6 +465,7 @@ bool CalPrintPluginBase::useColors() const
 void CalPrintPluginBase::setUseColors(bool useColors)
 {
     mUseColors = useColors;
+    mPreviewPages.clear();
 }
 
 bool CalPrintPluginBase::printFooter() const
@@ -238,11 +476,12 @@ bool CalPrintPluginBase::printFooter() const
 void CalPrintPluginBase::setPrintFooter(bool printFooter)
 {
     mPrintFooter = printFooter;
+    mPreviewPages.clear();
 }
 
 QPageLayout::Orientation CalPrintPluginBase::orientation() const
 {
-    return mPrinter ? mPrinter->pageLayout().orientation() : QPageLayout::Portrait;
+    return mPageLayout.orientation();
 }
 
 QColor CalPrintPluginBase::getTextColor(const QColor &c) const
@@ -299,9 +538,33 @@ QColor CalPrintPluginBase::categoryBgColor(const KCalendarCore::Incidence::Ptr &
     }
 }
 
+void CalPrintPluginBase::loadHolidays(QDate from, QDate to) const
+{
+    if (mHolidaysStart.isValid() && from >= mHolidaysStart && to < mHolidaysStart.addDays(mHolidays.count())) {
+        return;
+    }
+    mHolidays = holidays(from, to);
+    mHolidaysStart = from;
+}
+
+void CalPrintPluginBase::loadOccurrences(QDate from, QDate to)
+{
+    if (mOccurrences.covers(from, to)) {
+        return;
+    }
+    mOccurrences.build(mCalendar, from, to);
+}
+
+KCalendarCore::Event::List CalPrintPluginBase::eventsForDate(QDate date)
+{
+    loadOccurrences(date, date);
+    return mOccurrences.events(date);
+}
+
 QString CalPrintPluginBase::holidayString(QDate date) const
 {
-    const QStringList lst = holiday(date);
+    loadHolidays(date, date);
+    const QStringList &lst = mHolidays.at(mHolidaysStart.daysTo(date));
     return lst.join(i18nc("@item:intext delimiter for joining holiday names", ","));
 }
 
@@ -338,6 +601,7 @@ int CalPrintPluginBase::headerHeight() const
 void CalPrintPluginBase::setHeaderHeight(const int height)
 {
     mHeaderHeight = height;
+    mPreviewPages.clear();
 }
 
 int CalPrintPluginBase::subHeaderHeight() const
@@ -348,6 +612,7 @@ int CalPrintPluginBase::subHeaderHeight() const
 void CalPrintPluginBase::setSubHeaderHeight(const int height)
 {
     mSubHeaderHeight = height;
+    mPreviewPages.clear();
 }
 
 int CalPrintPluginBase::footerHeight() const
@@ -368,6 +633,7 @@ int CalPrintPluginBase::footerHeight() const
 void CalPrintPluginBase::setFooterHeight(const int height)
 {
     mFooterHeight = height;
+    mPreviewPages.clear();
 }
 
 int CalPrintPluginBase::margin() const
@@ -378,6 +644,7 @@ int CalPrintPluginBase::margin() const
 void CalPrintPluginBase::setMargin(const int margin)
 {
     mMargin = margin;
+    mPreviewPages.clear();
 }
 
 int CalPrintPluginBase::padding() const
@@ -388,6 +655,7 @@ int CalPrintPluginBase::padding() const
 void CalPrintPluginBase::setPadding(const int padding)
 {
     mPadding = padding;
+    mPreviewPages.clear();
 }
 
 int CalPrintPluginBase::borderWidth() const
@@ -398,6 +666,7 @@ int CalPrintPluginBase::borderWidth() const
 void CalPrintPluginBase::setBorderWidth(const int borderwidth)
 {
     mBorder = borderwidth;
+    mPreviewPages.clear();
 }
 
 void CalPrintPluginBase::drawBox(QPainter &p, int linewidth, QRect rect)
@@ -453,7 +722,7 @@ void CalPrintPluginBase::drawSubHeaderBox(QPainter &p, const QString &str, QRect
 {
     drawShadedBox(p, BOX_BORDER_WIDTH, QColor(232, 232, 232), box);
     QFont const oldfont(p.font());
-    p.setFont(QFont(u"sans-serif"_s, 10, QFont::Bold));
+    p.setFont(mStyles.font(10, QFont::Bold).font);
     p.drawText(box, Qt::AlignHCenter | Qt::AlignTop, str);
     p.setFont(oldfont);
 }
@@ -613,7 +882,7 @@ int CalPrintPluginBase::drawHeader(QPainter &p, const QString &title, QDate mont
 int CalPrintPluginBase::drawFooter(QPainter &p, QRect footbox)
 {
     QFont const oldfont(p.font());
-    p.setFont(QFont(u"sans-serif"_s, 6));
+    p.setFont(mStyles.font(6).font);
     QString const dateStr = QLocale::system().toString(QDateTime::currentDateTime(), QLocale::LongFormat);
     p.drawText(footbox, Qt::AlignCenter | Qt::AlignVCenter | Qt::TextSingleLine, i18nc("print date: formatted-datetime", "printed: %1", dateStr));
     p.setFont(oldfont);
@@ -730,6 +999,7 @@ void CalPrintPluginBase::drawTimeLine(QPainter &p, QTime fromTime, QTime toTime,
     }
     currY += (float(fromTime.secsTo(curTime) * minlen) / 60.);
 
+    const bool twelveHourClock = QLocale().timeFormat().contains("AP"_L1);
     while (curTime < endTime) {
         p.drawLine(box.left(), (int)currY, box.right(), (int)currY);
         int const newY = (int)(currY + cellHeight / 2.);
@@ -737,25 +1007,25 @@ void CalPrintPluginBase::drawTimeLine(QPainter &p, QTime fromTime, QTime toTime,
             QString numStr;
             QFont const oldFont(p.font());
             // draw the time:
-            if (!QLocale().timeFormat().contains("AP"_L1)) { // 12h clock
+            if (!twelveHourClock) {
                 p.drawLine(xcenter, (int)newY, box.right(), (int)newY);
                 numStr.setNum(curTime.hour());
                 if (cellHeight > 30) {
-                    p.setFont(QFont(u"sans-serif"_s, 14, QFont::Bold));
+                    p.setFont(mStyles.font(14, QFont::Bold).font);
                 } else {
-                    p.setFont(QFont(u"sans-serif"_s, 12, QFont::Bold));
+                    p.setFont(mStyles.font(12, QFont::Bold).font);
                 }
                 p.drawText(box.left() + 4, (int)currY + 2, box.width() / 2 - 2, (int)cellHeight, Qt::AlignTop | Qt::AlignRight, numStr);
-                p.setFont(QFont(u"helvetica"_s, 10, QFont::Normal));
+                p.setFont(mStyles.font(10, QFont::Normal, false, PrintStyleCache::Helvetica).font);
                 p.drawText(xcenter + 4, (int)currY + 2, box.width() / 2 + 2, (int)(cellHeight / 2) - 3, Qt::AlignTop | Qt::AlignLeft, u"00"_s);
             } else {
                 p.drawLine(box.left(), (int)newY, box.right(), (int)newY);
                 QTime const time(curTime.hour(), 0);
                 numStr = QLocale::system().toString(time, QLocale::ShortFormat);
                 if (box.width() < 60) {
-                    p.setFont(QFont(u"sans-serif"_s, 7, QFont::Bold)); // for weekprint
+                    p.setFont(mStyles.font(7, QFont::Bold).font); // for weekprint
                 } else {
-                    p.setFont(QFont(u"sans-serif"_s, 12, QFont::Bold)); // for dayprint
+                    p.setFont(mStyles.font(12, QFont::Bold).font); // for dayprint
                 }
                 p.drawText(box.left() + 2, (int)currY + 2, box.width() - 4, (int)cellHeight / 2 - 3, Qt::AlignTop | Qt::AlignLeft, numStr);
             }
@@ -779,8 +1049,7 @@ void CalPrintPluginBase::drawAgendaDayBox(QPainter &p,
                                           QRect box,
                                           bool includeDescription,
                                           bool includeCategories,
-                                          bool excludeTime,
-                                          const QList<QDate> &workDays)
+                                          bool excludeTime)
 {
     QTime myFromTime;
     QTime myToTime;
@@ -795,7 +1064,7 @@ void CalPrintPluginBase::drawAgendaDayBox(QPainter &p,
         myToTime = QTime(23, 59, 59);
     }
 
-    if (!workDays.contains(qd)) {
+    if (!isWorkDay(qd)) {
         drawShadedBox(p, BOX_BORDER_WIDTH, sHolidayBackground, box);
     } else {
         drawBox(p, BOX_BORDER_WIDTH, box);
@@ -863,32 +1132,47 @@ void CalPrintPluginBase::drawAgendaDayBox(QPainter &p,
 
     QList<CellItem *> cells;
 
-    for (const KCalendarCore::Event::Ptr &event : std::as_const(eventList)) {
+    const auto isPrinted = [this](const KCalendarCore::Event::Ptr &event) {
         if (!event || (mExcludeConfidential && event->secrecy() == KCalendarCore::Incidence::SecrecyConfidential)
             || (mExcludePrivate && event->secrecy() == KCalendarCore::Incidence::SecrecyPrivate)) {
-            continue;
+            return false;
         }
-        if (event->allDay()) {
-            continue;
+        return !event->allDay();
+    };
+
+    if (mOccurrences.covers(qd, qd)) {
+        // Take the occurrences from the print job's index, restricted to the events we were given.
+        QSet<const KCalendarCore::Event *> events;
+        events.reserve(eventList.count());
+        for (const KCalendarCore::Event::Ptr &event : std::as_const(eventList)) {
+            events.insert(event.data());
+        }
+        for (const auto &occurrence : mOccurrences.occurrences(qd)) {
+            if (events.contains(occurrence.event.data()) && isPrinted(occurrence.event)) {
+                cells.append(new PrintCellItem(occurrence.event, occurrence.start, occurrence.end));
+            }
         }
-        QList<QDateTime> const times = event->startDateTimesForDate(qd, QTimeZone::systemTimeZone());
-        cells.reserve(times.count());
-        for (auto it = times.constBegin(); it != times.constEnd(); ++it) {
-            cells.append(new PrintCellItem(event, (*it).toLocalTime(), event->endDateForStart(*it).toLocalTime()));
+    } else {
+        for (const KCalendarCore::Event::Ptr &event : std::as_const(eventList)) {
+            if (!isPrinted(event)) {
+                continue;
+            }
+            QList<QDateTime> const times = event->startDateTimesForDate(qd, QTimeZone::systemTimeZone());
+            cells.reserve(times.count());
+            for (auto it = times.constBegin(); it != times.constEnd(); ++it) {
+                cells.append(new PrintCellItem(event, (*it).toLocalTime(), event->endDateForStart(*it).toLocalTime()));
+            }
         }
     }
 
-    QListIterator<CellItem *> it1(cells);
-    while (it1.hasNext()) {
-        CellItem *placeItem = it1.next();
-        CellItem::placeItem(cells, placeItem);
-    }
+    CellItem::placeItems(cells);
 
     QListIterator<CellItem *> it2(cells);
     while (it2.hasNext()) {
         auto placeItem = static_cast<PrintCellItem *>(it2.next());
         drawAgendaItem(placeItem, p, startPrintDate, endPrintDate, minlen, newbox, includeDescription, includeCategories, excludeTime);
     }
+    qDeleteAll(cells);
 }
 
 void CalPrintPluginBase::drawAgendaItem(PrintCellItem *item,
@@ -957,15 +1241,15 @@ void CalPrintPluginBase::drawAgendaItem(PrintCellItem *item,
         if (eventBox.height() < 24) {
             if (eventBox.height() < 12) {
                 if (eventBox.height() < 8) {
-                    p.setFont(QFont(u"sans-serif"_s, 4));
+                    p.setFont(mStyles.font(4).font);
                 } else {
-                    p.setFont(QFont(u"sans-serif"_s, 5));
+                    p.setFont(mStyles.font(5).font);
                 }
             } else {
-                p.setFont(QFont(u"sans-serif"_s, 6));
+                p.setFont(mStyles.font(6).font);
             }
         } else {
-            p.setFont(QFont(u"sans-serif"_s, 8));
+            p.setFont(mStyles.font(8).font);
         }
         showEventBox(p, EVENT_BORDER_WIDTH, eventBox, event, str);
         p.setFont(oldFont);
@@ -1019,22 +1303,21 @@ void CalPrintPluginBase::drawDayBox(QPainter &p,
     const QFont oldFont(p.font());
 
     QRect const headerTextBox(subHeaderBox.adjusted(5, 0, -5, 0));
-    p.setFont(QFont(u"sans-serif"_s, 10, QFont::Bold));
+    p.setFont(mStyles.font(10, QFont::Bold).font);
     QRect dayNumRect;
     p.drawText(headerTextBox, Qt::AlignRight | Qt::AlignVCenter, dayNumStr, &dayNumRect);
     if (!hstring.isEmpty()) {
-        p.setFont(QFont(u"sans-serif"_s, 8, QFont::Bold, true));
-        QFontMetrics const fm(p.font());
-        hstring = fm.elidedText(hstring, Qt::ElideRight, headerTextBox.width() - dayNumRect.width() - 5);
+        PrintStyleCache::Font &holidayFont = mStyles.font(8, QFont::Bold, true);
+        p.setFont(holidayFont.font);
+        hstring = holidayFont.elidedText(hstring, headerTextBox.width() - dayNumRect.width() - 5);
         p.drawText(headerTextBox, Qt::AlignLeft | Qt::AlignVCenter, hstring);
-        p.setFont(QFont(u"sans-serif"_s, 10, QFont::Bold));
+        p.setFont(mStyles.font(10, QFont::Bold).font);
     }
 
-    const KCalendarCore::Event::List eventList =
-        mCalendar->events(qd, QTimeZone::systemTimeZone(), KCalendarCore::EventSortStartDate, KCalendarCore::SortDirectionAscending);
+    const KCalendarCore::Event::List eventList = eventsForDate(qd);
 
     QString timeText;
-    p.setFont(QFont(u"sans-serif"_s, 7));
+    p.setFont(mStyles.font(7).font);
 
     int textY = mSubHeaderHeight; // gives the relative y-coord of the next printed entry
     unsigned int visibleEventsCounter = 0;
@@ -1080,8 +1363,7 @@ void CalPrintPluginBase::drawDayBox(QPainter &p,
             if (invisibleIncidences > 0) {
                 const QString warningMsg = u"%1 (%2)"_s.arg(downArrow).arg(invisibleIncidences);
 
-                QFontMetrics const fm(p.font());
-                QRect msgRect = fm.boundingRect(warningMsg);
+                QRect msgRect = mStyles.font(p.font()).metrics.boundingRect(warningMsg);
                 msgRect.setRect(box.right() - msgRect.width() - 2, box.bottom() - msgRect.height() - 2, msgRect.width(), msgRect.height());
 
                 p.save();
@@ -1301,15 +1583,6 @@ void CalPrintPluginBase::drawMonth(QPainter &p, QDate dt, QRect box, int maxdays
     // Backgrounded boxes for each day, plus day numbers
     QBrush const oldbrush(p.brush());
 
-    QList<QDate> workDays;
-
-    {
-        QDate const startDate(dt.year(), dt.month(), 1);
-        QDate const endDate(dt.year(), dt.month(), daysinmonth);
-
-        workDays = CalendarSupport::workDays(startDate, endDate);
-    }
-
     for (int d = 0; d < daysinmonth; ++d) {
         QDate const day(dt.year(), dt.month(), d + 1);
         QRect dayBox(daysBox.left() /*+rand()%50*/, daysBox.top() + qRound(dayheight * d), daysBox.width() /*-rand()%50*/, 0);
@@ -1317,7 +1590,7 @@ void CalPrintPluginBase::drawMonth(QPainter &p, QDate dt, QRect box, int maxdays
         // don't let the rectangles overlap, i.e. subtract 1 from the top or bottom!
         dayBox.setBottom(daysBox.top() + qRound(dayheight * (d + 1)) - 1);
 
-        p.setBrush(workDays.contains(day) ? workdayColor : holidayColor);
+        p.setBrush(isWorkDay(day) ? workdayColor : holidayColor);
         p.drawRect(dayBox);
         QRect dateBox(dayBox);
         dateBox.setWidth(dayNrWidth + 3);
@@ -1330,7 +1603,6 @@ void CalPrintPluginBase::drawMonth(QPainter &p, QDate dt, QRect box, int maxdays
     QDate end = start.addMonths(1);
     end = end.addDays(-1);
 
-    const KCalendarCore::Event::List events = mCalendar->events(start, end);
     QMap<int, QStringList> textEvents;
     QList<CellItem *> timeboxItems;
 
@@ -1342,6 +1614,7 @@ void CalPrintPluginBase::drawMonth(QPainter &p, QDate dt, QRect box, int maxdays
 
     // Holidays
     // QList<KCalendarCore::Event::Ptr> holidays;
+    loadHolidays(start, end);
     for (QDate d(start); d <= end; d = d.addDays(1)) {
         KCalendarCore::Event::Ptr const e = holidayEvent(d);
         if (e) {
@@ -1357,38 +1630,20 @@ void CalPrintPluginBase::drawMonth(QPainter &p, QDate dt, QRect box, int maxdays
 
     QList<MonthEventStruct> monthentries;
 
-    for (const KCalendarCore::Event::Ptr &e : std::as_const(events)) {
-        if (!e || (mExcludeConfidential && e->secrecy() == KCalendarCore::Incidence::SecrecyConfidential)
-            || (mExcludePrivate && e->secrecy() == KCalendarCore::Incidence::SecrecyPrivate)) {
-            continue;
-        }
-        if (e->recurs()) {
-            if (e->recursOn(start, QTimeZone::systemTimeZone())) {
-                // This occurrence has possibly started before the beginning of the
-                // month, so obtain the start date before the beginning of the month
-                QList<QDateTime> const starttimes = e->startDateTimesForDate(start, QTimeZone::systemTimeZone());
-                for (auto it = starttimes.constBegin(); it != starttimes.constEnd(); ++it) {
-                    monthentries.append(MonthEventStruct((*it).toLocalTime(), e->endDateForStart(*it).toLocalTime(), e));
-                }
+    loadOccurrences(start, end);
+    for (QDate d(start); d <= end; d = d.addDays(1)) {
+        for (const auto &occurrence : mOccurrences.occurrences(d)) {
+            // Occurrences spanning several days are listed on each of them, only take them
+            // at their first day in the month.
+            if (d != start && occurrence.start.date() != d) {
+                continue;
             }
-            // Loop through all remaining days of the month and check if the event
-            // begins on that day (don't use Event::recursOn, as that will
-            // also return events that have started earlier. These start dates
-            // however, have already been treated!
-            KCalendarCore::Recurrence const *recur = e->recurrence();
-            QDate d1(start.addDays(1));
-            while (d1 <= end) {
-                if (recur->recursOn(d1, QTimeZone::systemTimeZone())) {
-                    KCalendarCore::TimeList const times(recur->recurTimesOn(d1, QTimeZone::systemTimeZone()));
-                    for (KCalendarCore::TimeList::ConstIterator it = times.constBegin(); it != times.constEnd(); ++it) {
-                        QDateTime const d1start(d1, *it, QTimeZone::LocalTime);
-                        monthentries.append(MonthEventStruct(d1start, e->endDateForStart(d1start).toLocalTime(), e));
-                    }
-                }
-                d1 = d1.addDays(1);
+            const KCalendarCore::Event::Ptr &e = occurrence.event;
+            if ((mExcludeConfidential && e->secrecy() == KCalendarCore::Incidence::SecrecyConfidential)
+                || (mExcludePrivate && e->secrecy() == KCalendarCore::Incidence::SecrecyPrivate)) {
+                continue;
             }
-        } else {
-            monthentries.append(MonthEventStruct(e->dtStart().toLocalTime(), e->dtEnd().toLocalTime(), e));
+            monthentries.append(MonthEventStruct(occurrence.start, occurrence.end, e));
         }
     }
 
@@ -1424,16 +1679,13 @@ void CalPrintPluginBase::drawMonth(QPainter &p, QDate dt, QRect box, int maxdays
     }
 
     // For Multi-day events, line them up nicely so that the boxes don't overlap
+    CellItem::placeItems(timeboxItems);
     QListIterator<CellItem *> it1(timeboxItems);
-    while (it1.hasNext()) {
-        CellItem *placeItem = it1.next();
-        CellItem::placeItem(timeboxItems, placeItem);
-    }
     QDateTime const starttime(start, QTime(0, 0, 0));
     int newxstartcont = xstartcont;
 
     QFont const oldfont(p.font());
-    p.setFont(QFont(u"sans-serif"_s, 7));
+    p.setFont(mStyles.font(7).font);
     while (it1.hasNext()) {
         auto placeItem = static_cast<PrintCellItem *>(it1.next());
         int const minsToStart = starttime.secsTo(placeItem->start()) / 60;
@@ -1448,6 +1700,7 @@ void CalPrintPluginBase::drawMonth(QPainter &p, QDate dt, QRect box, int maxdays
         newxstartcont = qMax(newxstartcont, eventBox.right());
     }
     xstartcont = newxstartcont;
+    qDeleteAll(timeboxItems);
 
     // For Single-day events, simply print their summaries into the remaining
     // space of the day's cell
@@ -1522,6 +1775,9 @@ void CalPrintPluginBase::drawMonthTable(QPainter &p,
     daysOfWeekBox.setLeft(box.left() + xoffset);
     drawDaysOfWeek(p, monthDate, monthDate.addDays(6), daysOfWeekBox);
 
+    loadHolidays(monthDate, monthDate.addDays(rows * 7 - 1));
+    loadOccurrences(monthDate, monthDate.addDays(rows * 7 - 1));
+
     QColor const back = p.background().color();
     bool darkbg = false;
     for (int row = 0; row < rows; ++row) {
@@ -1552,42 +1808,31 @@ void CalPrintPluginBase::drawTodoLines(QPainter &p,
                                        QList<TodoParentStart *> &startPoints,
                                        bool connectSubTodos)
 {
-    QString const plainEntry = richTextEntry ? toPlainText(entry) : entry;
-
-    QRect const textrect(0, 0, width, -1);
-    int const flags = Qt::AlignLeft;
-    QFontMetrics fm = p.fontMetrics();
-
-    QStringList lines = plainEntry.split(u'\n');
-    for (int currentLine = 0; currentLine < lines.count(); currentLine++) {
-        // split paragraphs into lines
-        KWordWrap const ww = KWordWrap::formatText(fm, textrect, flags, lines[currentLine]);
-        QStringList textLine = ww.wrappedString().split(u'\n');
-
-        // print each individual line
-        for (int lineCount = 0; lineCount < textLine.count(); lineCount++) {
-            if (y >= pageHeight) {
-                if (connectSubTodos) {
-                    for (int i = 0; i < startPoints.size(); ++i) {
-                        TodoParentStart *rct;
-                        rct = startPoints.at(i);
-                        int start = rct->mRect.bottom() + 1;
-                        int const center = rct->mRect.left() + (rct->mRect.width() / 2);
-                        if (!rct->mSamePage) {
-                            start = 0;
-                        }
-                        if (rct->mHasLine) {
-                            p.drawLine(center, start, center, y);
-                        }
-                        rct->mSamePage = false;
+    const PrintTextLayoutCache::Layout layout = mTextLayouts.layout(p, entry, width, richTextEntry);
+
+    // print each individual line
+    for (const QString &line : layout.lines) {
+        if (y >= pageHeight) {
+            if (connectSubTodos) {
+                for (int i = 0; i < startPoints.size(); ++i) {
+                    TodoParentStart *rct;
+                    rct = startPoints.at(i);
+                    int start = rct->mRect.bottom() + 1;
+                    int const center = rct->mRect.left() + (rct->mRect.width() / 2);
+                    if (!rct->mSamePage) {
+                        start = 0;
                     }
+                    if (rct->mHasLine) {
+                        p.drawLine(center, start, center, y);
+                    }
+                    rct->mSamePage = false;
                 }
-                y = 0;
-                mPrinter->newPage();
             }
-            y += fm.height();
-            p.drawText(x, y, textLine[lineCount]);
+            y = 0;
+            newPage(p);
         }
+        y += layout.lineHeight;
+        p.drawText(x, y, line);
     }
 }
 
@@ -1610,16 +1855,14 @@ void CalPrintPluginBase::drawTodo(int &count,
                                   int &y,
                                   int width,
                                   int pageHeight,
-                                  const KCalendarCore::Todo::List &todoList,
+                                  TodoTree &tree,
                                   TodoParentStart *r)
 {
     QString outStr;
     const auto locale = QLocale::system();
     QRect rect;
     TodoParentStart startpt;
-    // This list keeps all starting points of the parent to-dos so the connection
-    // lines of the tree can easily be drawn (needed if a new page is started)
-    static QList<TodoParentStart *> startPoints;
+    QList<TodoParentStart *> &startPoints = tree.mStartPoints;
     if (level < 1) {
         startPoints.clear();
     }
@@ -1636,7 +1879,7 @@ void CalPrintPluginBase::drawTodo(int &count,
     // first line is checked! Word-wrapped summaries might still overflow!)
     if (y + fm.height() >= pageHeight) {
         y = 0;
-        mPrinter->newPage();
+        newPage(p);
         // reset the parent start points to indicate not on same page
         for (int i = 0; i < startPoints.size(); ++i) {
             TodoParentStart *rct;
@@ -1734,14 +1977,14 @@ void CalPrintPluginBase::drawTodo(int &count,
     if (posCategories >= 0) {
         outStr = todo->categoriesStr();
         outStr.replace(u',', u'\n');
-        rect = p.boundingRect(posCategories, top, posSoFar - posCategories, -1, Qt::TextWordWrap, outStr);
+        rect = mTextLayouts.boundingRect(p, posCategories, top, posSoFar - posCategories, Qt::TextWordWrap, outStr);
         p.drawText(rect, Qt::TextWordWrap, outStr, &categoriesRect);
         posSoFar = posCategories;
     }
 
     // summary
     outStr = todo->summary();
-    rect = p.boundingRect(lhs, top, posSoFar - lhs - 5, -1, Qt::TextWordWrap, outStr);
+    rect = mTextLayouts.boundingRect(p, lhs, top, posSoFar - lhs - 5, Qt::TextWordWrap, outStr);
     QFont const oldFont(p.font());
     if (strikeoutCompleted && todo->isCompleted()) {
         QFont newFont(p.font());
@@ -1760,47 +2003,15 @@ void CalPrintPluginBase::drawTodo(int &count,
         drawTodoLines(p, todo->description(), left, y, width - (left + 10 - x), pageHeight, todo->descriptionIsRich(), startPoints, connectSubTodos);
     }
 
-    // Make a list of all the sub-to-dos related to this to-do.
-    KCalendarCore::Todo::List t;
-    const auto incidences = mCalendar->incidences();
-    for (const KCalendarCore::Incidence::Ptr &incidence : incidences) {
-        // In the future, to-dos might also be related to events
-        // Manually check if the sub-to-do is in the list of to-dos to print
-        // The problem is that relations() does not apply filters, so
-        // we need to compare manually with the complete filtered list!
-        KCalendarCore::Todo::Ptr const subtodo = incidence.dynamicCast<KCalendarCore::Todo>();
-        if (!subtodo) {
-            continue;
-        }
-
-        if (subtodo->relatedTo() != todo->uid()) {
-            continue;
-        }
-
-        bool subtodoOk = false;
-        for (const KCalendarCore::Todo::Ptr &tt : std::as_const(todoList)) {
-            if (tt == subtodo) {
-                subtodoOk = true;
-                break;
-            }
-        }
-
-        if (subtodoOk) {
-            t.append(subtodo);
-        }
-    }
+    // The sub-to-dos related to this to-do which are to be printed.
+    KCalendarCore::Todo::List t = tree.children(todo);
 
     // has sub-todos?
     startpt.mHasLine = (!t.isEmpty());
     startPoints.append(&startpt);
 
     // Sort the sub-to-dos and print them
-    KCalendarCore::Todo::List tl;
-    tl.reserve(t.count());
-    for (const KCalendarCore::Todo::Ptr &subtodo : std::as_const(t)) {
-        tl.append(subtodo);
-    }
-    KCalendarCore::Todo::List sl = mCalendar->sortTodos(std::move(tl), sortField, sortDir);
+    KCalendarCore::Todo::List const sl = mCalendar->sortTodos(std::move(t), sortField, sortDir);
 
     int subcount = 0;
     for (const KCalendarCore::Todo::Ptr &isl : std::as_const(sl)) {
@@ -1827,7 +2038,7 @@ void CalPrintPluginBase::drawTodo(int &count,
                  y,
                  width,
                  pageHeight,
-                 todoList,
+                 tree,
                  &startpt);
     }
     startPoints.removeAll(&startpt);
@@ -1841,29 +2052,19 @@ int CalPrintPluginBase::weekdayColumn(int weekday)
 
 void CalPrintPluginBase::drawTextLines(QPainter &p, const QString &entry, int x, int &y, int width, int pageHeight, bool richTextEntry)
 {
-    QString const plainEntry = richTextEntry ? toPlainText(entry) : entry;
-
-    QRect const textrect(0, 0, width, -1);
-    int const flags = Qt::AlignLeft;
-    QFontMetrics fm = p.fontMetrics();
-
-    QStringList lines = plainEntry.split(u'\n');
-    for (int currentLine = 0; currentLine < lines.count(); currentLine++) {
-        // split paragraphs into lines
-        KWordWrap const ww = KWordWrap::formatText(fm, textrect, flags, lines[currentLine]);
-        QStringList textLine = ww.wrappedString().split(u'\n');
-        // print each individual line
-        for (int lineCount = 0; lineCount < textLine.count(); lineCount++) {
-            y += fm.height();
-            if (y >= pageHeight) {
-                if (mPrintFooter) {
-                    drawFooter(p, {0, pageHeight, width, footerHeight()});
-                }
-                y = fm.height();
-                mPrinter->newPage();
+    const PrintTextLayoutCache::Layout layout = mTextLayouts.layout(p, entry, width, richTextEntry);
+
+    // print each individual line
+    for (const QString &line : layout.lines) {
+        y += layout.lineHeight;
+        if (y >= pageHeight) {
+            if (mPrintFooter) {
+                drawFooter(p, {0, pageHeight, width, footerHeight()});
             }
-            p.drawText(x, y, textLine[lineCount]);
+            y = layout.lineHeight;
+            newPage(p);
         }
+        p.drawText(x, y, line);
     }
 }
 
@@ -1892,9 +2093,9 @@ void CalPrintPluginBase::drawSplitHeaderRight(QPainter &p, QDate fd, QDate td, Q
     }
 
     if (height < 60) {
-        p.setFont(QFont(u"Times"_s, 22));
+        p.setFont(mStyles.font(22, QFont::Normal, false, PrintStyleCache::Times).font);
     } else {
-        p.setFont(QFont(u"Times"_s, 28));
+        p.setFont(mStyles.font(28, QFont::Normal, false, PrintStyleCache::Times).font);
     }
 
     int const lineSpacing = p.fontMetrics().lineSpacing();
@@ -1907,9 +2108,9 @@ void CalPrintPluginBase::drawSplitHeaderRight(QPainter &p, QDate fd, QDate td, Q
     p.setPen(oldPen);
 
     if (height < 60) {
-        p.setFont(QFont(u"Times"_s, 14, QFont::Bold, true));
+        p.setFont(mStyles.font(14, QFont::Bold, true, PrintStyleCache::Times).font);
     } else {
-        p.setFont(QFont(u"Times"_s, 18, QFont::Bold, true));
+        p.setFont(mStyles.font(18, QFont::Bold, true, PrintStyleCache::Times).font);
     }
 
     title += QString::number(fd.year());
@@ -1939,5 +2140,5 @@ void CalPrintPluginBase::drawNoteLines(QPainter &p, QRect box, int startY)
 QString CalPrintPluginBase::toPlainText(const QString &htmlText)
 {
     // this converts possible rich text to plain text
-    return QTextDocumentFragment::fromHtml(htmlText).toPlainText();
+    return mTextLayouts.plainText(htmlText);
 }
@@ -10,13 +10,17 @@
 #pragma once
 
 #include "calendarsupport_export.h"
+#include "occurrenceindex.h"
 #include "printplugin.h"
+#include "printstylecache.h"
+#include "printtextlayoutcache.h"
 
 #include <KCalendarCore/Calendar>
 #include <KCalendarCore/Event>
 #include <KCalendarCore/Todo>
 
 #include <QDateTime>
+#include <QHash>
 #include <QPainter>
 
 class PrintCellItem;
@@ -74,6 +78,21 @@ public:
     */
     void doPrint(QPrinter *printer) override;
 
+    /**
+      Prints for a print preview. The pages are recorded once and replayed on
+      later repaints, until the page layout, the printed range or incidences,
+      the calendar or the settings change.
+    */
+    void doPrintPreview(QPrinter *printer) override;
+
+    bool render(QPagedPaintDevice *device, QDate from, QDate to, const RenderOptions &options = {}) override;
+    [[nodiscard]] QList<QPicture> renderPages(const QPageLayout &layout, QDate from, QDate to, const RenderOptions &options = {}) override;
+    [[nodiscard]] QList<QImage> renderImages(const QPageLayout &layout, int resolution, QDate from, QDate to, const RenderOptions &options = {}) override;
+
+    void setCalendar(const KCalendarCore::Calendar::Ptr &cal) override;
+    void setSelectedIncidences(const KCalendarCore::Incidence::List &inc) override;
+    void setDateRange(const QDate &from, const QDate &to) override;
+
     void doLoadConfig() override;
 
     void doSaveConfig() override;
@@ -316,7 +335,6 @@ public:
       @param includeDescription Whether to print the event description as well.
       @param includeCategories Whether to print the event categories (tags) as well.
       @param excludeTime Whether the time is printed in the detail area.
-      @param workDays List of workDays
     */
     void drawAgendaDayBox(QPainter &p,
                           const KCalendarCore::Event::List &eventList,
@@ -327,8 +345,7 @@ public:
                           QRect box,
                           bool includeDescription,
                           bool includeCategories,
-                          bool excludeTime,
-                          const QList<QDate> &workDays);
+                          bool excludeTime);
 
     void drawAgendaItem(PrintCellItem *item,
                         QPainter &p,
@@ -427,6 +444,33 @@ public:
     */
     class TodoParentStart;
 
+    /**
+      The to-dos of a printout arranged as a tree, built once per printout
+      and passed to drawTodo().
+    */
+    class TodoTree
+    {
+    public:
+        /**
+          Builds the tree of the to-dos in @p todoList. Sub-to-dos that are not
+          part of @p todoList are left out, as are to-dos listed twice.
+        */
+        explicit TodoTree(const KCalendarCore::Todo::List &todoList);
+
+        /**
+          Returns the sub-to-dos of @p todo, in the order of the list the tree
+          was built from.
+        */
+        KCalendarCore::Todo::List children(const KCalendarCore::Todo::Ptr &todo) const;
+
+        // All starting points of the parent to-dos being printed, so the connection
+        // lines of the tree can easily be drawn (needed if a new page is started)
+        QList<TodoParentStart *> mStartPoints;
+
+    private:
+        QHash<QString, KCalendarCore::Todo::List> mChildren;
+    };
+
     /**
       Draws single to-do and its (indented) sub-to-dos, optionally connects them
       by a tree-like line, and optionally shows due date, summary, description
@@ -463,7 +507,8 @@ public:
       @param width width of the whole to-do list.
       @param pageHeight Total height allowed for the to-do list on a page.
       If an to-do would be below that line, a new page is started.
-      @param todoList Contains a list of sub-todos for the specified @p todo .
+      @param tree The tree of the to-dos to print. Only the
+      sub-to-dos of @p todo that are part of the tree are printed.
       @param r Internal (used when printing sub-to-dos to give information
       about its parent)
     */
@@ -486,7 +531,7 @@ public:
                   int &y,
                   int width,
                   int pageHeight,
-                  const KCalendarCore::Todo::List &todoList,
+                  TodoTree &tree,
                   TodoParentStart *r);
 
     /**
@@ -511,6 +556,14 @@ public:
     void drawNoteLines(QPainter &p, QRect box, int startY);
 
 protected:
+    /**
+      Starts a new page of the printout. Plugins call this rather than
+      QPrinter::newPage(), as there is no printer when the pages are rendered
+      with renderPages().
+      @param p QPainter of the printout
+    */
+    void newPage(QPainter &p);
+
     QTime dayStart() const;
     QColor categoryBgColor(const KCalendarCore::Incidence::Ptr &incidence) const;
 
@@ -538,6 +591,30 @@ protected:
 
     KCalendarCore::Event::Ptr holidayEvent(QDate date) const;
 
+    QString holidayString(QDate date) const;
+
+    /**
+      Looks up the holidays between @p from and @p to in one go, so that
+      holidayString() and holidayEvent() do not have to query the holiday
+      regions again for each day in that range.
+    */
+    void loadHolidays(QDate from, QDate to) const;
+
+    /**
+      Expands the occurrences of all events between @p from and @p to once for
+      the current print job. Plugins call this with their whole printed range
+      before drawing, the draw* helpers then look up their days in mOccurrences
+      instead of querying the calendar for each of them.
+      Does nothing if the range is already covered.
+    */
+    void loadOccurrences(QDate from, QDate to);
+
+    /**
+      Returns the events taking place on @p date sorted by start, like
+      Calendar::events( @p date ) does, using the print job's occurrence index.
+    */
+    KCalendarCore::Event::List eventsForDate(QDate date);
+
 protected:
     bool mUseColors; /**< Whether or not to use event category colors to draw the events. */
     bool mPrintFooter; /**< Whether or not to print a footer at the bottoms of pages. */
@@ -551,9 +628,18 @@ protected:
     int mPadding;
     int mBorder;
 
+    OccurrenceIndex mOccurrences; /**< The occurrences of the printed events, see loadOccurrences(). */
+    PrintStyleCache mStyles; /**< The fonts of the print job. */
+    PrintTextLayoutCache mTextLayouts; /**< The word-wrapped texts of the print job. */
+
     static const QColor sHolidayBackground;
 
 private:
+    // Clears what is cached for a single print job
+    void startPrintJob();
+    // Records the pages of the printout with the current settings, see renderPages()
+    QList<QPicture> recordPages(const QPageLayout &layout);
+
     QColor categoryColor(const QStringList &categories) const;
 
     /**
@@ -561,11 +647,24 @@ private:
      */
     void setColorsByIncidenceCategory(QPainter &p, const KCalendarCore::Incidence::Ptr &incidence) const;
 
-    QString holidayString(QDate date) const;
-
     /**
      * Returns a nice QColor for text, give the input color &c.
      */
     QColor getTextColor(const QColor &c) const;
+
+    // Holiday names of the days starting at mHolidaysStart, see loadHolidays()
+    mutable QList<QStringList> mHolidays;
+    mutable QDate mHolidaysStart;
+
+    // The device the printout is painted to directly, or nullptr if the pages
+    // are recorded into mPages
+    QPagedPaintDevice *mPaintDevice = nullptr;
+    QPageLayout mPageLayout;
+    QRect mPageRect;
+    QList<QPicture> mPages;
+
+    // The pages recorded for the print preview, for mPreviewLayout
+    QList<QPicture> mPreviewPages;
+    QPageLayout mPreviewLayout;
 };
 }
@@ -96,7 +96,7 @@ void CalPrintJournal::setDateRange(const QDate &from, const QDate &to)
 void CalPrintJournal::drawJournal(const KCalendarCore::Journal::Ptr &journal, QPainter &p, int x, int &y, int width, int pageHeight)
 {
     QFont const oldFont(p.font());
-    p.setFont(QFont(u"sans-serif"_s, 15));
+    p.setFont(mStyles.font(15).font);
     QString headerText;
     QString const dateText(QLocale::system().toString(journal->dtStart().toLocalTime().date(), QLocale::LongFormat));
 
@@ -106,15 +106,15 @@ void CalPrintJournal::drawJournal(const KCalendarCore::Journal::Ptr &journal, QP
         headerText = i18nc("Description - date", "%1 - %2", journal->summary(), dateText);
     }
 
-    QRect rect(p.boundingRect(x, y, width, -1, Qt::TextWordWrap, headerText));
+    QRect rect(mTextLayouts.boundingRect(p, x, y, width, Qt::TextWordWrap, headerText));
     if (rect.bottom() > pageHeight) {
         if (mPrintFooter) {
             drawFooter(p, {0, pageHeight, width, footerHeight()});
         }
         // Start new page...
         y = 0;
-        mPrinter->newPage();
-        rect = p.boundingRect(x, y, width, -1, Qt::TextWordWrap, headerText);
+        newPage(p);
+        rect = mTextLayouts.boundingRect(p, x, y, width, Qt::TextWordWrap, headerText);
     }
     QRect newrect;
     p.drawText(rect, Qt::TextWordWrap, headerText, &newrect);
@@ -0,0 +1,150 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#include "occurrenceindex.h"
+
+#include <KCalendarCore/CalFilter>
+
+#include <QSet>
+#include <QTimeZone>
+
+#include <algorithm>
+
+using namespace CalendarSupport;
+
+namespace
+{
+struct ExpandedOccurrence {
+    OccurrenceIndex::Occurrence occurrence;
+    QDate firstDay;
+    QDate lastDay;
+};
+
+ExpandedOccurrence expand(const KCalendarCore::Event::Ptr &event, const QDateTime &start, const QDateTime &end)
+{
+    ExpandedOccurrence result;
+    if (event->allDay()) {
+        result.firstDay = start.date();
+        result.lastDay = end.isValid() ? end.date() : result.firstDay;
+        result.occurrence = {event, QDateTime(result.firstDay, QTime(0, 0), QTimeZone::LocalTime), QDateTime(result.lastDay, QTime(0, 0), QTimeZone::LocalTime)};
+    } else {
+        const QDateTime localStart = start.toLocalTime();
+        const QDateTime localEnd = end.isValid() ? end.toLocalTime() : localStart;
+        result.firstDay = localStart.date();
+        result.lastDay = localEnd.date();
+        // An occurrence ending at midnight doesn't take place on the following day.
+        if (localEnd > localStart && localEnd.time() == QTime(0, 0)) {
+            result.lastDay = result.lastDay.addDays(-1);
+        }
+        result.occurrence = {event, localStart, localEnd};
+    }
+    result.lastDay = std::max(result.lastDay, result.firstDay);
+    return result;
+}
+}
+
+void OccurrenceIndex::build(const KCalendarCore::Calendar::Ptr &calendar, QDate from, QDate to)
+{
+    clear();
+    if (!calendar || !from.isValid() || !to.isValid() || from > to) {
+        return;
+    }
+    mFrom = from;
+    mTo = to;
+
+    const QDateTime rangeStart(from, QTime(0, 0), QTimeZone::LocalTime);
+    const QDateTime rangeEnd(to.addDays(1), QTime(0, 0), QTimeZone::LocalTime);
+    const KCalendarCore::CalFilter *filter = calendar->filter();
+
+    std::vector<ExpandedOccurrence> expanded;
+    const KCalendarCore::Event::List events = calendar->rawEvents();
+    for (const KCalendarCore::Event::Ptr &event : events) {
+        if (!event || (filter && !filter->filterIncidence(event))) {
+            continue;
+        }
+        const auto add = [&](const QDateTime &start, const QDateTime &end) {
+            ExpandedOccurrence occurrence = expand(event, start, end);
+            if (occurrence.firstDay <= to && occurrence.lastDay >= from) {
+                expanded.push_back(std::move(occurrence));
+            }
+        };
+        if (event->recurs()) {
+            // Also look for occurrences that started before the range but reach into it.
+            const qint64 lookBack = event->dtStart().secsTo(event->dtEnd()) + 24 * 60 * 60;
+            const auto times = event->recurrence()->timesInInterval(rangeStart.addSecs(-lookBack), rangeEnd);
+            for (const QDateTime &start : times) {
+                add(start, event->endDateForStart(start));
+            }
+        } else {
+            add(event->dtStart(), event->dtEnd());
+        }
+    }
+
+    // Count the occurrences per day, then put each of them into the buckets of its days.
+    const qsizetype days = from.daysTo(to) + 1;
+    mDayOffsets.assign(days + 1, 0);
+    for (const ExpandedOccurrence &occurrence : expanded) {
+        const qsizetype first = std::max<qsizetype>(from.daysTo(occurrence.firstDay), 0);
+        const qsizetype last = std::min<qsizetype>(from.daysTo(occurrence.lastDay), days - 1);
+        for (qsizetype day = first; day <= last; ++day) {
+            ++mDayOffsets[day + 1];
+        }
+    }
+    for (qsizetype day = 0; day < days; ++day) {
+        mDayOffsets[day + 1] += mDayOffsets[day];
+    }
+
+    mEntries.resize(mDayOffsets[days]);
+    std::vector<qsizetype> fill(mDayOffsets.begin(), mDayOffsets.end() - 1);
+    for (const ExpandedOccurrence &occurrence : expanded) {
+        const qsizetype first = std::max<qsizetype>(from.daysTo(occurrence.firstDay), 0);
+        const qsizetype last = std::min<qsizetype>(from.daysTo(occurrence.lastDay), days - 1);
+        for (qsizetype day = first; day <= last; ++day) {
+            mEntries[fill[day]++] = occurrence.occurrence;
+        }
+    }
+
+    for (qsizetype day = 0; day < days; ++day) {
+        std::stable_sort(mEntries.begin() + mDayOffsets[day], mEntries.begin() + mDayOffsets[day + 1], [](const Occurrence &a, const Occurrence &b) {
+            return a.start < b.start;
+        });
+    }
+}
+
+void OccurrenceIndex::clear()
+{
+    mFrom = QDate();
+    mTo = QDate();
+    mEntries.clear();
+    mDayOffsets.clear();
+}
+
+bool OccurrenceIndex::covers(QDate from, QDate to) const
+{
+    return mFrom.isValid() && from >= mFrom && to <= mTo;
+}
+
+QSpan<const OccurrenceIndex::Occurrence> OccurrenceIndex::occurrences(QDate date) const
+{
+    if (!covers(date, date)) {
+        return {};
+    }
+    const qsizetype day = mFrom.daysTo(date);
+    return QSpan<const Occurrence>(mEntries.data() + mDayOffsets[day], mDayOffsets[day + 1] - mDayOffsets[day]);
+}
+
+KCalendarCore::Event::List OccurrenceIndex::events(QDate date) const
+{
+    KCalendarCore::Event::List events;
+    QSet<const KCalendarCore::Event *> seen;
+    for (const Occurrence &occurrence : occurrences(date)) {
+        if (!seen.contains(occurrence.event.data())) {
+            seen.insert(occurrence.event.data());
+            events.append(occurrence.event);
+        }
+    }
+    return events;
+}
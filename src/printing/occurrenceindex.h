@@ -0,0 +1,69 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#pragma once
+
+#include <KCalendarCore/Calendar>
+#include <KCalendarCore/Event>
+
+#include <QDate>
+#include <QDateTime>
+#include <QSpan>
+
+#include <vector>
+
+namespace CalendarSupport
+{
+/**
+  The occurrences of all events of a calendar within a date range, expanded
+  once and bucketed by day.
+
+  Each occurrence is stored in the bucket of every day it spans, so looking up
+  the occurrences of a day is a plain array access. Within a day, occurrences
+  are sorted by their start.
+*/
+class OccurrenceIndex
+{
+public:
+    struct Occurrence {
+        KCalendarCore::Event::Ptr event;
+        QDateTime start; // local time; midnight of the first day for all-day events
+        QDateTime end; // local time; midnight of the last day for all-day events
+    };
+
+    /**
+      Expands the occurrences of all events of @p calendar that take place between
+      @p from and @p to (inclusive), honoring the calendar's filter.
+    */
+    void build(const KCalendarCore::Calendar::Ptr &calendar, QDate from, QDate to);
+
+    void clear();
+
+    /**
+      Returns true if the index was built for a range including @p from to @p to.
+    */
+    [[nodiscard]] bool covers(QDate from, QDate to) const;
+
+    /**
+      Returns the occurrences taking place on @p date, sorted by start.
+      @p date must be covered by the index.
+    */
+    [[nodiscard]] QSpan<const Occurrence> occurrences(QDate date) const;
+
+    /**
+      Returns the events taking place on @p date, sorted by the start of
+      their first occurrence on that day.
+    */
+    [[nodiscard]] KCalendarCore::Event::List events(QDate date) const;
+
+private:
+    QDate mFrom;
+    QDate mTo;
+    std::vector<Occurrence> mEntries;
+    // the occurrences of the day mFrom + i are mEntries[mDayOffsets[i]] to mEntries[mDayOffsets[i + 1] - 1]
+    std::vector<qsizetype> mDayOffsets;
+};
+}
@@ -11,6 +11,8 @@
 #include <KConfig>
 
 #include <QDate>
+#include <QImage>
+#include <QPicture>
 #include <QPointer>
 #include <QPrinter>
 #include <QWidget>
@@ -52,6 +54,18 @@ public:
 
     using List = QList<PrintPlugin *>;
 
+    /**
+      Options of a printout rendered without dialogs, see render().
+      \since 6.9.0
+    */
+    struct RenderOptions {
+        /** The incidences to print, for the styles printing selected incidences. */
+        KCalendarCore::Incidence::List selectedIncidences;
+        /** If positive, render() paints the pages as images of this resolution in dpi,
+            which are rasterized on all cores, rather than as vector graphics. */
+        int rasterResolution = 0;
+    };
+
     virtual void setConfig(KConfig *cfg)
     {
         mConfig = cfg;
@@ -125,6 +139,86 @@ public:
     */
     virtual void doPrint(QPrinter *printer) = 0;
 
+    /**
+      Prints for a print preview, which repaints whenever its page setup changes
+      or it is zoomed. Plugins may replay what they printed for the previous
+      repaint, as long as the page layout and their settings did not change.
+      It is only called with the preview's own printer; printing from the
+      preview goes through doPrint(). The default implementation calls doPrint().
+      \since 6.9.0
+    */
+    virtual void doPrintPreview(QPrinter *printer)
+    {
+        doPrint(printer);
+    }
+
+    /**
+      Renders the printout of the dates from @p from to @p to into @p device,
+      using the current settings of the plugin and without showing any dialog,
+      so that calendars can be printed in batch or to PDF files with QPdfWriter.
+      The page layout of @p device is used.
+
+      Only raster output, see RenderOptions::rasterResolution, is painted on all
+      cores. Vector output, like printing with doPrint(), paints the pages one
+      after another, since a paged device takes a single painter at a time.
+
+      The default implementation only supports printers; plugins that can render
+      without a printer override it.
+      @return false if the printout could not be rendered into @p device
+      \since 6.9.0
+    */
+    virtual bool render(QPagedPaintDevice *device, QDate from, QDate to, const RenderOptions &options = {})
+    {
+        auto printer = dynamic_cast<QPrinter *>(device);
+        if (!printer) {
+            return false;
+        }
+        const QDate fromDate = mFromDate;
+        const QDate toDate = mToDate;
+        const KCalendarCore::Incidence::List selectedIncidences = mSelectedIncidences;
+        setDateRange(from, to);
+        setSelectedIncidences(options.selectedIncidences);
+        doPrint(printer);
+        setDateRange(fromDate, toDate);
+        setSelectedIncidences(selectedIncidences);
+        return true;
+    }
+
+    /**
+      Renders the printout like render(), as one picture per page. The pictures
+      have the size of the printable area of @p layout at the resolution of QPicture,
+      and can be replayed into images or other paint devices.
+
+      The default implementation returns no pages.
+      \since 6.9.0
+    */
+    [[nodiscard]] virtual QList<QPicture> renderPages(const QPageLayout &layout, QDate from, QDate to, const RenderOptions &options = {})
+    {
+        Q_UNUSED(layout)
+        Q_UNUSED(from)
+        Q_UNUSED(to)
+        Q_UNUSED(options)
+        return {};
+    }
+
+    /**
+      Renders the printout like renderPages(), as white images of @p resolution
+      dpi. The pages are laid out one after another, then painted in parallel.
+
+      The default implementation returns no pages.
+      \since 6.9.0
+    */
+    [[nodiscard]] virtual QList<QImage>
+    renderImages(const QPageLayout &layout, int resolution, QDate from, QDate to, const RenderOptions &options = {})
+    {
+        Q_UNUSED(layout)
+        Q_UNUSED(resolution)
+        Q_UNUSED(from)
+        Q_UNUSED(to)
+        Q_UNUSED(options)
+        return {};
+    }
+
     /**
       Orientation of printout. Default is Portrait. If your plugin wants
       to use some other orientation as default (e.g. depending on some
@@ -0,0 +1,69 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#include "printstylecache.h"
+
+using namespace CalendarSupport;
+using namespace Qt::Literals::StringLiterals;
+
+static QString familyName(PrintStyleCache::Family family)
+{
+    switch (family) {
+    case PrintStyleCache::Helvetica:
+        return u"helvetica"_s;
+    case PrintStyleCache::Times:
+        return u"Times"_s;
+    case PrintStyleCache::SansSerif:
+        break;
+    }
+    return u"sans-serif"_s;
+}
+
+PrintStyleCache::Font::Font(const QFont &font)
+    : font(font)
+    , metrics(font)
+{
+}
+
+int PrintStyleCache::Font::horizontalAdvance(const QString &text)
+{
+    auto it = mAdvances.constFind(text);
+    if (it == mAdvances.cend()) {
+        it = mAdvances.insert(text, metrics.horizontalAdvance(text));
+    }
+    return it.value();
+}
+
+QString PrintStyleCache::Font::elidedText(const QString &text, int width)
+{
+    const std::pair<QString, int> key(text, width);
+    auto it = mElidedTexts.constFind(key);
+    if (it == mElidedTexts.cend()) {
+        it = mElidedTexts.insert(key, metrics.elidedText(text, Qt::ElideRight, width));
+    }
+    return it.value();
+}
+
+PrintStyleCache::Font &PrintStyleCache::font(int pointSize, QFont::Weight weight, bool italic, Family family)
+{
+    const quint64 style = (quint64(pointSize) << 32) | (quint64(weight) << 16) | (quint64(italic) << 8) | quint64(family);
+    Font *&entry = mFontsByStyle[style];
+    if (!entry) {
+        entry = &font(QFont(familyName(family), pointSize, weight, italic));
+    }
+    return *entry;
+}
+
+PrintStyleCache::Font &PrintStyleCache::font(const QFont &qfont)
+{
+    return mFonts.try_emplace(qfont, qfont).first->second;
+}
+
+void PrintStyleCache::clear()
+{
+    mFontsByStyle.clear();
+    mFonts.clear();
+}
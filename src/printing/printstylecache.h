@@ -0,0 +1,87 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#pragma once
+
+#include <QFont>
+#include <QFontMetrics>
+#include <QHash>
+#include <QString>
+
+#include <unordered_map>
+#include <utility>
+
+namespace CalendarSupport
+{
+/**
+  The fonts of a print job, with their metrics and measurements of the texts
+  printed in them.
+
+  The print styles use a handful of fonts for every day box, time label and
+  to-do line. Taking them from this cache resolves each font once per print job,
+  and measures or elides each text once per font.
+*/
+class PrintStyleCache
+{
+public:
+    enum Family {
+        SansSerif,
+        Helvetica,
+        Times
+    };
+
+    class Font
+    {
+    public:
+        explicit Font(const QFont &font);
+
+        const QFont font;
+        /** The metrics of the font, like QFontMetrics( font ) */
+        const QFontMetrics metrics;
+
+        /**
+          Returns the horizontal advance of @p text, see QFontMetrics::horizontalAdvance().
+        */
+        int horizontalAdvance(const QString &text);
+
+        /**
+          Returns @p text elided on the right to fit into @p width, see QFontMetrics::elidedText().
+        */
+        QString elidedText(const QString &text, int width);
+
+    private:
+        QHash<QString, int> mAdvances;
+        QHash<std::pair<QString, int>, QString> mElidedTexts;
+    };
+
+    /**
+      Returns the font of @p family in @p pointSize points.
+    */
+    Font &font(int pointSize, QFont::Weight weight = QFont::Normal, bool italic = false, Family family = SansSerif);
+
+    /**
+      Returns @p qfont.
+    */
+    Font &font(const QFont &qfont);
+
+    /**
+      Forgets all fonts and measurements.
+    */
+    void clear();
+
+private:
+    struct FontHash {
+        size_t operator()(const QFont &font) const
+        {
+            return qHash(font);
+        }
+    };
+
+    // Node based, so that the fonts stay in place
+    std::unordered_map<QFont, Font, FontHash> mFonts;
+    QHash<quint64, Font *> mFontsByStyle;
+};
+}
@@ -0,0 +1,73 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#include "printtextlayoutcache.h"
+
+#include <KWordWrap>
+
+#include <QPainter>
+#include <QTextDocumentFragment>
+
+using namespace CalendarSupport;
+
+// Marks layouts of rich text in the flags of their key
+static constexpr int RichTextFlag = 0x40000000;
+
+PrintTextLayoutCache::Key PrintTextLayoutCache::key(const QPainter &p, const QString &text, int width, int flags)
+{
+    const QPaintDevice *device = p.device();
+    return {text, p.font(), device ? device->logicalDpiX() : 0, device ? device->logicalDpiY() : 0, width, flags};
+}
+
+PrintTextLayoutCache::Layout PrintTextLayoutCache::layout(const QPainter &p, const QString &text, int width, bool richText)
+{
+    const Key k = key(p, text, width, richText ? RichTextFlag : 0);
+    auto it = mLayouts.constFind(k);
+    if (it != mLayouts.cend()) {
+        return it.value();
+    }
+
+    const QFontMetrics fm = p.fontMetrics();
+    const QRect textRect(0, 0, width, -1);
+    Layout layout;
+    layout.lineHeight = fm.height();
+
+    const QStringList paragraphs = (richText ? plainText(text) : text).split(u'\n');
+    for (const QString &paragraph : paragraphs) {
+        // split paragraphs into lines
+        const KWordWrap ww = KWordWrap::formatText(fm, textRect, Qt::AlignLeft, paragraph);
+        layout.lines += ww.wrappedString().split(u'\n');
+    }
+    mLayouts.insert(k, layout);
+    return layout;
+}
+
+QRect PrintTextLayoutCache::boundingRect(const QPainter &p, int x, int y, int width, int flags, const QString &text)
+{
+    const Key k = key(p, text, width, flags);
+    auto it = mSizes.constFind(k);
+    if (it == mSizes.cend()) {
+        // QPainter::boundingRect() is not const, but only measures
+        it = mSizes.insert(k, const_cast<QPainter &>(p).boundingRect(0, 0, width, -1, flags, text).size());
+    }
+    return {QPoint(x, y), it.value()};
+}
+
+QString PrintTextLayoutCache::plainText(const QString &htmlText)
+{
+    auto it = mPlainTexts.constFind(htmlText);
+    if (it == mPlainTexts.cend()) {
+        it = mPlainTexts.insert(htmlText, QTextDocumentFragment::fromHtml(htmlText).toPlainText());
+    }
+    return it.value();
+}
+
+void PrintTextLayoutCache::clear()
+{
+    mLayouts.clear();
+    mSizes.clear();
+    mPlainTexts.clear();
+}
@@ -0,0 +1,87 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: GPL-2.0-or-later WITH LicenseRef-Qt-Commercial-exception-1.0
+*/
+
+#pragma once
+
+#include <QFont>
+#include <QHash>
+#include <QRect>
+#include <QStringList>
+
+class QPainter;
+
+namespace CalendarSupport
+{
+/**
+  The word-wrapped texts of a print job.
+
+  Descriptions are converted from rich text and word-wrapped line by line when
+  they are printed, and the print styles measure texts again to decide whether
+  they still fit on the page. This cache does both once per text, font, paint
+  device resolution and width.
+*/
+class PrintTextLayoutCache
+{
+public:
+    /**
+      A text wrapped into lines.
+    */
+    class Layout
+    {
+    public:
+        /** The lines of the text, without line breaks */
+        QStringList lines;
+        /** The height of each line */
+        int lineHeight = 0;
+    };
+
+    /**
+      Returns @p text wrapped into lines of at most @p width in the font of @p p,
+      as drawn by CalPrintPluginBase::drawTextLines().
+      @param richText whether @p text is rich text, which is converted to plain text
+    */
+    Layout layout(const QPainter &p, const QString &text, int width, bool richText);
+
+    /**
+      Returns the rectangle of @p text drawn with @p flags into a rectangle of
+      @p width at @p x, @p y in the font of @p p, like QPainter::boundingRect().
+      Only for texts aligned to the top left.
+    */
+    QRect boundingRect(const QPainter &p, int x, int y, int width, int flags, const QString &text);
+
+    /**
+      Returns @p htmlText converted to plain text.
+    */
+    QString plainText(const QString &htmlText);
+
+    /**
+      Forgets all texts.
+    */
+    void clear();
+
+private:
+    struct Key {
+        QString text;
+        QFont font;
+        int logicalDpiX = 0;
+        int logicalDpiY = 0;
+        int width = 0;
+        int flags = 0;
+
+        bool operator==(const Key &other) const = default;
+    };
+    friend size_t qHash(const Key &key, size_t seed = 0)
+    {
+        return qHashMulti(seed, key.text, key.font, key.logicalDpiX, key.logicalDpiY, key.width, key.flags);
+    }
+
+    static Key key(const QPainter &p, const QString &text, int width, int flags);
+
+    QHash<Key, Layout> mLayouts;
+    QHash<Key, QSize> mSizes;
+    QHash<QString, QString> mPlainTexts;
+};
+}
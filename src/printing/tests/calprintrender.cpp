@@ -0,0 +1,125 @@
+/*
+  SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+// Prints iCalendar files with one of the default print styles, without any
+// dialog or display, into a PDF file or a PNG image per page.
+
+#include "../calprinter.h"
+
+#include <KCalendarCore/FileStorage>
+#include <KCalendarCore/MemoryCalendar>
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QPdfWriter>
+
+using namespace CalendarSupport;
+using namespace Qt::Literals::StringLiterals;
+
+static const QHash<QString, int> Styles = {
+    {u"incidence"_s, CalPrinterBase::Incidence},
+    {u"day"_s, CalPrinterBase::Day},
+    {u"week"_s, CalPrinterBase::Week},
+    {u"month"_s, CalPrinterBase::Month},
+    {u"year"_s, CalPrinterBase::Year},
+    {u"todo"_s, CalPrinterBase::Todolist},
+    {u"journal"_s, CalPrinterBase::Journallist},
+};
+
+static bool writeImages(const QList<QImage> &pages, const QString &baseName)
+{
+    for (qsizetype i = 0; i < pages.size(); ++i) {
+        if (!pages.at(i).save(u"%1-%2.png"_s.arg(baseName).arg(i + 1, 3, 10, u'0'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    // Nothing is shown, so do not require a display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(u"Prints calendars without dialogs"_s);
+    parser.addHelpOption();
+    parser.addOptions({
+        {u"style"_s, u"The print style: incidence, day, week, month, year, todo or journal."_s, u"style"_s, u"month"_s},
+        {u"from"_s, u"The first day to print, as YYYY-MM-DD. The default is today."_s, u"date"_s},
+        {u"to"_s, u"The last day to print, as YYYY-MM-DD. The default is the first day."_s, u"date"_s},
+        {u"format"_s, u"The output format: pdf, or png for an image per page."_s, u"format"_s, u"pdf"_s},
+        {u"orientation"_s, u"portrait or landscape. The default depends on the style."_s, u"orientation"_s},
+        {u"resolution"_s, u"The resolution of png images, in dpi."_s, u"dpi"_s, u"150"_s},
+        {{u"o"_s, u"output"_s}, u"The directory to write to."_s, u"directory"_s, u"."_s},
+    });
+    parser.addPositionalArgument(u"files"_s, u"The iCalendar files to print, each into a file of the same base name."_s, u"files..."_s);
+    parser.process(app);
+
+    const int type = Styles.value(parser.value(u"style"_s), -1);
+    const QString format = parser.value(u"format"_s);
+    if (type < 0 || (format != "pdf"_L1 && format != "png"_L1) || parser.positionalArguments().isEmpty()) {
+        parser.showHelp(1);
+    }
+    const QDate from = parser.isSet(u"from"_s) ? QDate::fromString(parser.value(u"from"_s), Qt::ISODate) : QDate::currentDate();
+    const QDate to = parser.isSet(u"to"_s) ? QDate::fromString(parser.value(u"to"_s), Qt::ISODate) : from;
+    if (!from.isValid() || !to.isValid() || to < from) {
+        qCritical("Invalid date range");
+        return 1;
+    }
+    const QDir output(parser.value(u"output"_s));
+
+    KCalendarCore::MemoryCalendar::Ptr const calendar(new KCalendarCore::MemoryCalendar(QTimeZone::systemTimeZone()));
+    CalPrinter printer(nullptr, calendar);
+    int failures = 0;
+    QElapsedTimer timer;
+    const QStringList files = parser.positionalArguments();
+    for (const QString &file : files) {
+        timer.start();
+        calendar->close();
+        KCalendarCore::FileStorage storage(calendar, file);
+        if (!storage.load()) {
+            qWarning("Unable to load %s", qPrintable(file));
+            ++failures;
+            continue;
+        }
+        PrintPlugin *plugin = printer.printPlugin(type);
+
+        PrintPlugin::RenderOptions options;
+        if (type == CalPrinterBase::Incidence) {
+            options.selectedIncidences = calendar->incidences();
+        }
+        QPageLayout::Orientation orientation = plugin->defaultOrientation();
+        if (parser.isSet(u"orientation"_s)) {
+            orientation = parser.value(u"orientation"_s) == "landscape"_L1 ? QPageLayout::Landscape : QPageLayout::Portrait;
+        }
+        const QPageLayout layout(QPageSize(QPageSize::A4), orientation, QMarginsF(10, 10, 10, 10), QPageLayout::Millimeter);
+
+        const QString baseName = output.filePath(QFileInfo(file).completeBaseName());
+        bool ok = false;
+        if (format == "pdf"_L1) {
+            QPdfWriter writer(baseName + u".pdf"_s);
+            writer.setPageLayout(layout);
+            ok = plugin->render(&writer, from, to, options);
+        } else {
+            ok = writeImages(plugin->renderImages(layout, parser.value(u"resolution"_s).toInt(), from, to, options), baseName);
+        }
+        if (!ok) {
+            qWarning("Unable to print %s", qPrintable(file));
+            ++failures;
+            continue;
+        }
+        qInfo("%s: %lld ms", qPrintable(file), timer.elapsed());
+    }
+    return failures == 0 ? 0 : 2;
+}
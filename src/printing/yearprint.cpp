@@ -115,6 +115,7 @@ void CalPrintYear::print(QPainter &p, int width, int height)
     height -= footerHeight();
 
     QDate start(mYear, 1, 1);
+    loadOccurrences(start, QDate(mYear, 12, 31));
 
     // Determine the nr of months and the max nr of days per month (dependent on
     // calendar system!!!!)
@@ -134,7 +135,7 @@ void CalPrintYear::print(QPainter &p, int width, int height)
     temp = start;
     for (int page = 0; page < pages; ++page) {
         if (page > 0) {
-            mPrinter->newPage();
+            newPage(p);
         }
         QDate end = start.addMonths(monthsPerPage);
         end = end.addDays(-1);
@@ -10,6 +10,7 @@
 using namespace Qt::Literals::StringLiterals;
 
 #include "calendarsupport_debug.h"
+#include "holidaycache.h"
 #include "kcalprefs.h"
 
 #include <Akonadi/AgentInstance>
@@ -24,8 +25,6 @@ using namespace Qt::Literals::StringLiterals;
 #include <Akonadi/BlockAlarmsAttribute>
 #include <Akonadi/ETMCalendar>
 
-#include <KHolidays/HolidayRegion>
-
 #include <KCalendarCore/CalFilter>
 #include <KCalendarCore/FileStorage>
 #include <KCalendarCore/FreeBusy>
@@ -460,78 +459,22 @@ QString CalendarSupport::subMimeTypeForIncidence(const KCalendarCore::Incidence:
 
 QList<QDate> CalendarSupport::workDays(QDate startDate, QDate endDate)
 {
-    QList<QDate> result;
-
-    const int mask(~(KCalPrefs::instance()->mWorkWeekMask));
-    const int numDays = startDate.daysTo(endDate) + 1;
-
-    for (int i = 0; i < numDays; ++i) {
-        const QDate date = startDate.addDays(i);
-        if (!(mask & (1 << (date.dayOfWeek() - 1)))) {
-            result.append(date);
-        }
-    }
-
-    if (KCalPrefs::instance()->mExcludeHolidays) {
-        const QStringList holidays = KCalPrefs::instance()->mHolidays;
-        for (const QString &regionStr : holidays) {
-            KHolidays::HolidayRegion const region(regionStr);
-            if (region.isValid()) {
-                const auto list = region.rawHolidaysWithAstroSeasons(startDate, endDate);
-                for (auto const &h : list) {
-                    if (h.dayType() == KHolidays::Holiday::NonWorkday) {
-                        for (int i = 0; i < h.duration(); i++) {
-                            result.removeOne(h.observedStartDate().addDays(i));
-                        }
-                    }
-                }
-            }
-        }
-    }
+    return HolidayCache::instance()->workDays(startDate, endDate);
+}
 
-    return result;
+bool CalendarSupport::isWorkDay(QDate date)
+{
+    return HolidayCache::instance()->isWorkDay(date);
 }
 
 QStringList CalendarSupport::holiday(QDate date, const QStringList &categories)
 {
-    QStringList hdays;
-
-    bool const showCountryCode = (KCalPrefs::instance()->mHolidays.count() > 1);
-    const QStringList holidays = KCalPrefs::instance()->mHolidays;
-    for (const QString &regionStr : holidays) {
-        KHolidays::HolidayRegion region(regionStr);
-        if (region.isValid()) {
-            region.setCategories(categories);
-            const KHolidays::Holiday::List list = region.rawHolidaysWithAstroSeasons(date);
-            const int listCount = list.count();
-            for (int i = 0; i < listCount; ++i) {
-                // don't add duplicates.
-                // TODO: won't find duplicates in different languages however.
-                const QString name = list.at(i).name();
-                if (showCountryCode) {
-                    // If more than one holiday region, append the country code to the holiday
-                    // display name to help the user identify which region it belongs to.
-                    const QRegularExpression holidaySE(i18nc("search pattern for holidayname", "^%1", name));
-                    if (hdays.filter(holidaySE).isEmpty()) {
-                        const QString pholiday = i18n("%1 (%2)", name, region.countryCode());
-                        hdays.append(pholiday);
-                    } else {
-                        // More than 1 region has the same holiday => remove the country code
-                        // i.e don't show "Holiday (US)" and "Holiday(FR)"; just show "Holiday".
-                        const QRegularExpression holidayRE(i18nc("replace pattern for holidayname (countrycode)", "^%1 \\(.*\\)", name));
-                        hdays.replaceInStrings(holidayRE, name);
-                        hdays.removeDuplicates();
-                    }
-                } else {
-                    if (!hdays.contains(name)) {
-                        hdays.append(name);
-                    }
-                }
-            }
-        }
-    }
+    return HolidayCache::instance()->holidays(date, categories);
+}
 
-    return hdays;
+QList<QStringList> CalendarSupport::holidays(QDate from, QDate to, const QStringList &categories)
+{
+    return HolidayCache::instance()->holidays(from, to, categories);
 }
 
 QStringList CalendarSupport::categories(const KCalendarCore::Incidence::List &incidences)
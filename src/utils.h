@@ -164,6 +164,13 @@ CALENDARSUPPORT_EXPORT QString subMimeTypeForIncidence(const KCalendarCore::Inci
  */
 CALENDARSUPPORT_EXPORT QList<QDate> workDays(QDate start, QDate end);
 
+/*!
+ * Returns true if \a date is a work day, taking the work week and, if configured,
+ * the non-working days of the holiday regions into account.
+ * \since 6.9.0
+ */
+CALENDARSUPPORT_EXPORT bool isWorkDay(QDate date);
+
 /*!
  * Creates a nicely formatted toolTip string for a calendar, containing some quick,
  * useful information to the user.
@@ -182,6 +189,17 @@ CALENDARSUPPORT_EXPORT QString toolTipString(const Akonadi::Collection &coll, bo
  */
 CALENDARSUPPORT_EXPORT QStringList holiday(QDate date, const QStringList &categories = QStringList());
 
+/*!
+ * Returns the holidays that occur between \a from and \a to (inclusive), as a list
+ * with one entry per day starting at \a from, i.e. the holidays of a date \c d are
+ * at index \c {from.daysTo(d)}.
+ * This is the same as calling holiday() for each day, but the holiday regions are
+ * only evaluated once for the whole range.
+ * A list of categories can be used to filter the types of holidays that are returned.
+ * \since 6.9.0
+ */
+CALENDARSUPPORT_EXPORT QList<QStringList> holidays(QDate from, QDate to, const QStringList &categories = QStringList());
+
 CALENDARSUPPORT_EXPORT QStringList categories(const KCalendarCore::Incidence::List &incidences);
 
 CALENDARSUPPORT_EXPORT bool mergeCalendar(const QString &srcFilename, const KCalendarCore::Calendar::Ptr &destCalendar);